@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "parallel_scan.hpp"
+
+// Compressed sparse row storage of a one to many relation. All the rows live in
+// a single indices array, row i spans indices[offsets[i], offsets[i] +
+// sizes[i]) and can grow in place up to capacities[i] entries. A row that runs
+// out of slack is moved to the end of the indices array with twice the
+// capacity, leaving a hole behind. WARNING: growing a row beyond its capacity
+// can reallocate the indices array and invalidate the spans of all the other
+// rows, call reserve before iterating a row while appending to another. Row
+// sizes and capacities are int, only the indices take the Index type.
+template <typename Index = int>
+class BasicAdjacency {
+ public:
+  BasicAdjacency() = default;
+
+  // Make rows with the given capacities plus some slack for later growth, all
+  // rows start empty.
+  explicit BasicAdjacency(const std::vector<int>& capacities, int slack = 0)
+      : offsets_(capacities.size()),
+        sizes_(capacities.size(), 0),
+        capacities_(capacities.size()) {
+    for (size_t i = 0; i < capacities.size(); ++i)
+      capacities_[i] = capacities[i] + slack;
+    indices_.resize(utl::parallel_exclusive_scan(
+        utl::NUM_HARDWARE_THREADS, capacities_.begin(), size(),
+        offsets_.begin(), uint64_t{0}));
+  }
+
+  // Take ownership of the raw arrays (see data accessors).
+  BasicAdjacency(std::vector<uint64_t> offsets, std::vector<int> sizes,
+                 std::vector<int> capacities, std::vector<Index> indices)
+      : offsets_(std::move(offsets)),
+        sizes_(std::move(sizes)),
+        capacities_(std::move(capacities)),
+        indices_(std::move(indices)) {
+    assert(offsets_.size() == sizes_.size());
+    assert(offsets_.size() == capacities_.size());
+  }
+
+  size_t size() const { return offsets_.size(); }
+  bool empty() const { return offsets_.empty(); }
+
+  std::span<Index> operator[](size_t i) {
+    return {indices_.data() + offsets_[i], static_cast<size_t>(sizes_[i])};
+  }
+
+  std::span<const Index> operator[](size_t i) const {
+    return {indices_.data() + offsets_[i], static_cast<size_t>(sizes_[i])};
+  }
+
+  // Make sure row i can grow by count entries without moving.
+  void reserve(size_t i, size_t count) {
+    if (sizes_[i] + count <= static_cast<size_t>(capacities_[i])) return;
+
+    // Move the row to the end. If it is already the last one just extend it.
+    auto capacity = std::max<size_t>(2 * capacities_[i], sizes_[i] + count);
+    if (offsets_[i] + capacities_[i] != indices_.size()) {
+      auto offset = indices_.size();
+      indices_.resize(offset + capacity);
+      std::copy_n(indices_.begin() + offsets_[i], sizes_[i],
+                  indices_.begin() + offset);
+      offsets_[i] = offset;
+    } else {
+      indices_.resize(offsets_[i] + capacity);
+    }
+    capacities_[i] = capacity;
+  }
+
+  // Appending to different rows from different threads is safe as long as no
+  // row needs to move.
+  void push_back(size_t i, Index x) {
+    reserve(i, 1);
+    indices_[offsets_[i] + sizes_[i]++] = x;
+  }
+
+  // Shrink or grow row i within its capacity.
+  void resize(size_t i, size_t size) {
+    assert(size <= static_cast<size_t>(capacities_[i]));
+    sizes_[i] = size;
+  }
+
+  // Repack the rows contiguously in order leaving the given slack to each.
+  void compact(int slack = 0) {
+    std::vector<uint64_t> offsets(size());
+    std::vector<int> capacities(size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < size(); ++i) {
+      offsets[i] = offset;
+      capacities[i] = sizes_[i] + slack;
+      offset += capacities[i];
+    }
+
+    std::vector<Index> indices(offset);
+    for (size_t i = 0; i < size(); ++i)
+      std::copy_n(indices_.begin() + offsets_[i], sizes_[i],
+                  indices.begin() + offsets[i]);
+
+    offsets_.swap(offsets);
+    capacities_.swap(capacities);
+    indices_.swap(indices);
+  }
+
+  void swap(BasicAdjacency& other) {
+    offsets_.swap(other.offsets_);
+    sizes_.swap(other.sizes_);
+    capacities_.swap(other.capacities_);
+    indices_.swap(other.indices_);
+  }
+
+  // Raw arrays. Rows can be written directly through data() within their
+  // capacity, their sizes are then set with resize.
+  Index* data() { return indices_.data(); }
+  const std::vector<uint64_t>& offsets() const { return offsets_; }
+  const std::vector<int>& sizes() const { return sizes_; }
+  const std::vector<int>& capacities() const { return capacities_; }
+  const std::vector<Index>& indices() const { return indices_; }
+
+ private:
+  std::vector<uint64_t> offsets_;
+  std::vector<int> sizes_;
+  std::vector<int> capacities_;
+  std::vector<Index> indices_;
+};
+
+using Adjacency = BasicAdjacency<>;
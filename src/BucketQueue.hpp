@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Approximate min priority queue with the interface of IndexedHeap. Entries are
+// binned by cost on a logarithmic scale, BUCKETS_PER_OCTAVE bins per power of
+// two, and the bins are unordered: top is any entry of the lowest non-empty bin
+// (the last one put in it), so it costs at most about 1 / BUCKETS_PER_OCTAVE
+// more than the true minimum. Pushing, changing the cost of and removing a key
+// are O(1), popping is O(1) amortized over the scan of empty bins. Costs not
+// above 2^MIN_EXPONENT (including zero and negative ones) share the lowest bin,
+// costs above 2^MAX_EXPONENT the highest.
+template <typename Index = int>
+class BucketQueue {
+ public:
+  using Entry = std::pair<double, Index>;
+
+  static constexpr int BUCKETS_PER_OCTAVE = 8;
+  static constexpr int MIN_EXPONENT = -128;
+  static constexpr int MAX_EXPONENT = 64;
+  static constexpr int NUM_BUCKETS =
+      (MAX_EXPONENT - MIN_EXPONENT) * BUCKETS_PER_OCTAVE;
+
+  BucketQueue() = default;
+
+  explicit BucketQueue(Index num_keys)
+      : buckets_(NUM_BUCKETS),
+        bucket_of_(num_keys, -1),
+        positions_(num_keys, -1) {}
+
+  // Replace the content of the queue by the entries, keys must be distinct.
+  void assign(std::vector<Entry> entries) {
+    for (auto& bucket : buckets_) {
+      for (const auto& [cost, key] : bucket) bucket_of_[key] = -1;
+      bucket.clear();
+    }
+    size_ = 0;
+    min_bucket_ = NUM_BUCKETS;
+    for (const auto& [cost, key] : entries) {
+      assert(bucket_of_[key] == -1);
+      insert(key, cost);
+    }
+  }
+
+  bool empty() const { return size_ == 0; }
+  Index size() const { return size_; }
+  bool contains(Index key) const { return bucket_of_[key] != -1; }
+
+  // Entry of least cost up to the bin width.
+  const Entry& top() const {
+    assert(!empty());
+    return buckets_[min_bucket_].back();
+  }
+
+  void pop() { remove(top().second); }
+
+  // Insert the key or change its cost if already in.
+  void push(Index key, double cost) {
+    auto b = bucket_of_[key];
+    if (b == bucket(cost)) {
+      buckets_[b][positions_[key]].first = cost;
+      return;
+    }
+    if (b != -1) remove(key);
+    insert(key, cost);
+  }
+
+  // Remove the key if in.
+  void remove(Index key) {
+    auto b = bucket_of_[key];
+    if (b == -1) return;
+    bucket_of_[key] = -1;
+    --size_;
+
+    // Fill the hole with the last entry of the bin.
+    auto& entries = buckets_[b];
+    auto i = positions_[key];
+    if (i + 1 != static_cast<Index>(entries.size())) {
+      entries[i] = entries.back();
+      positions_[entries[i].second] = i;
+    }
+    entries.pop_back();
+
+    if (b == min_bucket_)
+      while (min_bucket_ < NUM_BUCKETS && buckets_[min_bucket_].empty())
+        ++min_bucket_;
+  }
+
+ private:
+  // The mantissa in [0.5, 1) is split linearly, which avoids a logarithm.
+  static int bucket(double cost) {
+    if (!(cost > std::ldexp(1.0, MIN_EXPONENT))) return 0;
+    int exponent;
+    auto mantissa = std::frexp(cost, &exponent);
+    if (exponent > MAX_EXPONENT) return NUM_BUCKETS - 1;
+    return (exponent - 1 - MIN_EXPONENT) * BUCKETS_PER_OCTAVE +
+           static_cast<int>((2.0 * mantissa - 1.0) * BUCKETS_PER_OCTAVE);
+  }
+
+  void insert(Index key, double cost) {
+    auto b = bucket(cost);
+    positions_[key] = static_cast<Index>(buckets_[b].size());
+    bucket_of_[key] = b;
+    buckets_[b].emplace_back(cost, key);
+    ++size_;
+    if (b < min_bucket_) min_bucket_ = b;
+  }
+
+  std::vector<std::vector<Entry>> buckets_;
+  // Bin of every key, -1 if not in, and its position in the bin.
+  std::vector<int> bucket_of_;
+  std::vector<Index> positions_;
+  Index size_ = 0;
+  int min_bucket_ = NUM_BUCKETS;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "Mesh.hpp"
+#include "edge_key.hpp"
+#include "parallel_task.hpp"
+
+// clang-format off
+// Corner table connectivity (Rossignac) of a consistently oriented triangle
+// mesh, an alternative to the v2f, v2v, f2f, v2e and e2f relations. Corner c
+// is the corner of face c / 3 at vertex f2v[c], it faces the edge going from
+// f2v[next(c)] to f2v[prev(c)]. The vertex to corner map is the face to vertex
+// connectivity of the mesh itself, so only two arrays are added:
+// o[c]: the corner facing the same edge from the other side (-1 on the
+// boundary and on non-manifold or inconsistently oriented edges).
+// vc[v]: one corner at v, for boundary vertices the first one met turning
+// counterclockwise, so that swinging from it visits the whole one-ring.
+//      v
+//     /c\      f = face(c)
+//    / f \     g = face(d)
+//   n_____p
+//    \ g /
+//     \d/
+// d = o[c], n = next(c), p = prev(c) and the edge (n, p) is shared.
+// clang-format on
+template <typename Index = int>
+struct BasicCornerTable {
+  std::vector<Index> o;
+  std::vector<Index> vc;
+
+  static Index face(Index c) { return c / 3; }
+  static Index next(Index c) { return c % 3 == 2 ? c - 2 : c + 1; }
+  static Index prev(Index c) { return c % 3 == 0 ? c + 2 : c - 1; }
+
+  // Next corner at the same vertex turning counterclockwise (across the edge
+  // from the vertex to the vertex of prev(c)), -1 on the boundary.
+  Index swing(Index c) const {
+    auto d = o[next(c)];
+    return d == -1 ? -1 : next(d);
+  }
+
+  // Next corner at the same vertex turning clockwise, -1 on the boundary.
+  Index unswing(Index c) const {
+    auto d = o[prev(c)];
+    return d == -1 ? -1 : prev(d);
+  }
+
+  // The edge faced by a corner is represented by the smaller of the two
+  // opposite corners.
+  Index canonical(Index c) const { return o[c] == -1 || c < o[c] ? c : o[c]; }
+
+  bool is_boundary_vertex(Index v) const { return o[prev(vc[v])] == -1; }
+
+  // Call task(c) for every corner around the vertex v in counterclockwise
+  // order.
+  template <typename Task>
+  void for_each_corner(Index v, Task&& task) const {
+    auto c0 = vc[v];
+    auto c = c0;
+    do {
+      task(c);
+      c = swing(c);
+    } while (c != -1 && c != c0);
+  }
+
+  // Make vc[v] valid again starting from any live corner at v.
+  void fix_vertex_corner(Index v, Index c) {
+    auto c0 = c;
+    for (auto d = unswing(c); d != -1 && d != c0; d = unswing(d)) c = d;
+    vc[v] = c;
+  }
+};
+
+using CornerTable = BasicCornerTable<>;
+
+// Build the corner table by sorting the corners on the (unordered) edge they
+// face, runs of exactly two corners facing the edge in opposite directions are
+// made opposite.
+template <typename Scalar, typename Index>
+void make_corner_table(const BasicMesh<Scalar, Index>& m,
+                       BasicCornerTable<Index>& ct) {
+  using CT = BasicCornerTable<Index>;
+
+  auto num_corners = static_cast<Index>(m.f2v.size());
+
+  // Key of the unordered edge, then the corner.
+  std::vector<std::pair<EdgeKey<Index>, Index>> keys(num_corners);
+  {
+    const auto task = [&](auto, auto c, auto end) {
+      for (; c < end; ++c) {
+        auto v0 = m.f2v[CT::next(c)];
+        auto v1 = m.f2v[CT::prev(c)];
+        keys[c] = {edge_key(std::min(v0, v1), std::max(v0, v1)), c};
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_corners, task);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  ct.o.assign(num_corners, -1);
+  for (size_t i = 0; i < keys.size();) {
+    auto j = i + 1;
+    while (j < keys.size() && keys[j].first == keys[i].first) ++j;
+
+    if (j - i == 2) {
+      auto c = keys[i].second;
+      auto d = keys[i + 1].second;
+      // Opposite corners see the edge in opposite directions.
+      if (m.f2v[CT::next(c)] == m.f2v[CT::prev(d)]) {
+        ct.o[c] = d;
+        ct.o[d] = c;
+      }
+    }
+    i = j;
+  }
+
+  ct.vc.assign(m.num_vertices(), -1);
+  for (Index c = 0; c < num_corners; ++c)
+    if (ct.vc[m.f2v[c]] == -1) ct.fix_vertex_corner(m.f2v[c], c);
+}
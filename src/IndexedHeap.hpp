@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+// Min priority queue of (cost, key) entries with keys in [0, num_keys), at most
+// one entry per key. The position of every key in the heap is tracked so that
+// the cost of a key can be changed (decreased or increased) or the key removed
+// in O(log n). The heap is ARITY-ary, wider nodes make it shallower and their
+// children share cache lines.
+template <typename Index = int, int ARITY = 4>
+class IndexedHeap {
+ public:
+  using Entry = std::pair<double, Index>;
+
+  IndexedHeap() = default;
+
+  explicit IndexedHeap(Index num_keys) : positions_(num_keys, -1) {}
+
+  // Replace the content of the heap by the entries in linear time, keys must
+  // be distinct.
+  void assign(std::vector<Entry> entries) {
+    for (const auto& [cost, key] : heap_) positions_[key] = -1;
+    heap_ = std::move(entries);
+    for (Index i = 0; i < size(); ++i) {
+      assert(positions_[heap_[i].second] == -1);
+      positions_[heap_[i].second] = i;
+    }
+    if (size() > 1)
+      for (auto i = (size() - 2) / ARITY; i >= 0; --i) sift_down(i);
+  }
+
+  bool empty() const { return heap_.empty(); }
+  Index size() const { return static_cast<Index>(heap_.size()); }
+  bool contains(Index key) const { return positions_[key] != -1; }
+
+  // Entry of least cost.
+  const Entry& top() const {
+    assert(!empty());
+    return heap_.front();
+  }
+
+  void pop() { remove(top().second); }
+
+  // Insert the key or change its cost if already in.
+  void push(Index key, double cost) {
+    auto i = positions_[key];
+    if (i == -1) {
+      i = size();
+      heap_.emplace_back(cost, key);
+      positions_[key] = i;
+      sift_up(i);
+    } else if (cost < heap_[i].first) {
+      heap_[i].first = cost;
+      sift_up(i);
+    } else {
+      heap_[i].first = cost;
+      sift_down(i);
+    }
+  }
+
+  // Remove the key if in.
+  void remove(Index key) {
+    auto i = positions_[key];
+    if (i == -1) return;
+    positions_[key] = -1;
+
+    auto last = heap_.back();
+    heap_.pop_back();
+    if (i == size()) return;
+
+    // Move the last entry to the hole, it can go either way.
+    place(i, last);
+    sift_up(i);
+    sift_down(positions_[last.second]);
+  }
+
+ private:
+  void place(Index i, const Entry& entry) {
+    heap_[i] = entry;
+    positions_[entry.second] = i;
+  }
+
+  void sift_up(Index i) {
+    auto entry = heap_[i];
+    while (i > 0) {
+      auto parent = (i - 1) / ARITY;
+      if (!(entry.first < heap_[parent].first)) break;
+      place(i, heap_[parent]);
+      i = parent;
+    }
+    place(i, entry);
+  }
+
+  void sift_down(Index i) {
+    auto entry = heap_[i];
+    auto n = size();
+    for (;;) {
+      auto first = i * ARITY + 1;
+      if (first >= n) break;
+
+      // Least child.
+      auto child = first;
+      auto end = first + ARITY < n ? first + ARITY : n;
+      for (auto c = first + 1; c < end; ++c)
+        if (heap_[c].first < heap_[child].first) child = c;
+
+      if (!(heap_[child].first < entry.first)) break;
+      place(i, heap_[child]);
+      i = child;
+    }
+    place(i, entry);
+  }
+
+  std::vector<Entry> heap_;
+  // Position of every key in heap_, -1 if not in.
+  std::vector<Index> positions_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. The mapping is released on
+// destruction, an empty or unreadable file results in a null data pointer.
+class MappedFile {
+ public:
+  explicit MappedFile(std::string_view filepath) {
+    int fd = ::open(std::string{filepath}.c_str(), O_RDONLY);
+    if (fd == -1) return;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* ptr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr != MAP_FAILED) {
+        // The whole file is scanned front to back.
+        ::madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+        ptr_ = static_cast<const char*>(ptr);
+        size_ = st.st_size;
+      }
+    }
+
+    // The mapping stays valid after closing the descriptor.
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    if (ptr_) ::munmap(const_cast<char*>(ptr_), size_);
+  }
+
+  bool is_open() const { return ptr_ != nullptr; }
+  const char* data() const { return ptr_; }
+  const char* begin() const { return ptr_; }
+  const char* end() const { return ptr_ + size_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* ptr_ = nullptr;
+  size_t size_ = 0;
+};
@@ -1,35 +1,59 @@
 #pragma once
 
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
-struct Mesh {
-  std::vector<double> v;
-  std::vector<double> t;
-  std::vector<double> n;
-  std::vector<int> f2v;
-  std::vector<int> f2t;
-  std::vector<int> f2n;
+#include "Adjacency.hpp"
+
+// Free entries per vertex row of v2f, v2v and v2e for what the collapse
+// appends.
+inline constexpr int ADJACENCY_SLACK = 4;
+
+// Scalar is the type of positions, texture coordinates, normals and areas,
+// Index the type of all the indices. Indices must be signed as -1 marks
+// missing elements (e.g. the second flap of a boundary edge).
+template <typename Scalar = double, typename Index = int>
+struct BasicMesh {
+  static_assert(std::is_floating_point_v<Scalar>);
+  static_assert(std::is_integral_v<Index> && std::is_signed_v<Index>);
+
+  using scalar_type = Scalar;
+  using index_type = Index;
+
+  std::vector<Scalar> v;
+  std::vector<Scalar> t;
+  std::vector<Scalar> n;
+  std::vector<Index> f2v;
+  std::vector<Index> f2t;
+  std::vector<Index> f2n;
 
   auto num_faces() const { return f2v.size() / 3; }
   auto num_vertices() const { return v.size() / 3; }
   auto num_normals() const { return n.size() / 3; }
   auto num_texture() const { return t.size() / 2; }
 
-  std::vector<std::vector<int>> v2f;
-  std::vector<std::vector<int>> v2v;
-  std::vector<std::vector<int>> f2f;
+  BasicAdjacency<Index> v2f;
+  BasicAdjacency<Index> v2v;
+  BasicAdjacency<Index> f2f;
 
-  std::vector<int> e2v;
-  std::vector<std::vector<int>> v2e;
-  std::vector<int> e2f;
+  std::vector<Index> e2v;
+  BasicAdjacency<Index> v2e;
+  std::vector<Index> e2f;
 
   auto num_edges() const { return e2v.size() / 2; }
 
-  std::vector<double> fn;
-  std::vector<double> fa;
+  std::vector<Scalar> fn;
+  std::vector<Scalar> fa;
 
   // Mark if a face is deleted.
   std::vector<char> vdel;
   std::vector<char> fdel;
   std::vector<char> edel;
-};
\ No newline at end of file
+};
+
+using Mesh = BasicMesh<>;
+// Half the memory of the positions and normals.
+using FloatMesh = BasicMesh<float, int32_t>;
+// For meshes with more than 2^31 corners.
+using LargeMesh = BasicMesh<double, int64_t>;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of the binary mesh cache. After the header come blocks in a fixed
+// order, each one is a uint64_t element count followed by the raw elements,
+// padded to a multiple of 8 bytes so that every block is aligned when the file
+// is mapped. Adjacency relations are stored as their raw arrays, blocks of
+// uint64_t offsets, int sizes, int capacities and int indices, so that they
+// are restored without any rebuild. Data is in the host byte order.
+//
+// Blocks: v, t, n, f2v, f2t, f2n,
+// if TOPOLOGY: v2f, v2v, f2f, e2v, v2e, e2f,
+// if NORMALS_AND_AREAS: fn, fa.
+namespace cache {
+
+inline constexpr char MAGIC[8] = {'Q', 'S', 'L', 'I', 'M', 'M', 'C', '\0'};
+inline constexpr uint32_t VERSION = 2;
+
+enum : uint32_t { TOPOLOGY = 1, NORMALS_AND_AREAS = 2 };
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+};
+
+static_assert(sizeof(Header) % 8 == 0);
+
+constexpr uint64_t padded(uint64_t num_bytes) {
+  return (num_bytes + 7) & ~7ull;
+}
+
+}  // namespace cache
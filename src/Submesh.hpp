@@ -0,0 +1,118 @@
+#pragma once
+
+#include <robin_hood.h>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+// View of a subset of the faces of a parent mesh (e.g. a connected component)
+// that copies nothing on construction. The local numbering of the vertices (in
+// order of first use over the faces of the view) and the faces in that
+// numbering are built on first use of vertices() or f2v() and kept, or written
+// to buffers of the caller by number_vertices. Positions and the other
+// attributes are only copied by compacted, whose connectivity is then built on
+// the copy. The parent and the face list must outlive the view. Lazy members
+// make const views unsafe to share between threads until they are built.
+template <typename Scalar = double, typename Index = int>
+class BasicSubmesh {
+ public:
+  using MeshT = BasicMesh<Scalar, Index>;
+
+  BasicSubmesh(const MeshT& parent, std::span<const Index> faces)
+      : parent_(&parent), faces_(faces) {}
+
+  const MeshT& parent() const { return *parent_; }
+  // Parent indices of the faces.
+  std::span<const Index> faces() const { return faces_; }
+
+  auto num_faces() const { return faces_.size(); }
+  auto num_vertices() const { return vertices().size(); }
+
+  // Parent index of every local vertex.
+  const std::vector<Index>& vertices() const {
+    build_vertices();
+    return vertices_;
+  }
+
+  // Local vertices of the faces.
+  const std::vector<Index>& f2v() const {
+    build_vertices();
+    return f2v_;
+  }
+
+  // Same as vertices() and f2v() but written to vertices and f2v, the view
+  // keeps nothing.
+  void number_vertices(std::vector<Index>& vertices,
+                       std::vector<Index>& f2v) const {
+    vertices.clear();
+    remap(parent_->f2v, vertices, f2v);
+  }
+
+  // Standalone copy of the view with positions, texture coordinates and
+  // normals renumbered in order of first use. No connectivity is built and the
+  // view keeps no numbering.
+  MeshT compacted() const {
+    MeshT m;
+
+    std::vector<Index> vs;
+    if (f2v_.empty()) {
+      number_vertices(vs, m.f2v);
+    } else {
+      vs = vertices_;
+      m.f2v = f2v_;
+    }
+    m.v.resize(vs.size() * 3);
+    for (size_t i = 0; i < vs.size(); ++i)
+      std::copy_n(&parent_->v[vs[i] * 3], 3, &m.v[i * 3]);
+
+    if (!parent_->t.empty()) {
+      std::vector<Index> ts;
+      remap(parent_->f2t, ts, m.f2t);
+      m.t.resize(ts.size() * 2);
+      for (size_t i = 0; i < ts.size(); ++i)
+        std::copy_n(&parent_->t[ts[i] * 2], 2, &m.t[i * 2]);
+    }
+
+    if (!parent_->n.empty()) {
+      std::vector<Index> ns;
+      remap(parent_->f2n, ns, m.f2n);
+      m.n.resize(ns.size() * 3);
+      for (size_t i = 0; i < ns.size(); ++i)
+        std::copy_n(&parent_->n[ns[i] * 3], 3, &m.n[i * 3]);
+    }
+
+    return m;
+  }
+
+ private:
+  // Number the parent indices of ibuf used by the faces of the view in order
+  // of first use, the cost only depends on the size of the view.
+  void remap(const std::vector<Index>& ibuf, std::vector<Index>& sources,
+             std::vector<Index>& indices) const {
+    robin_hood::unordered_flat_map<Index, Index> map;
+    map.reserve(faces_.size());
+    indices.resize(faces_.size() * 3);
+    for (size_t f = 0; f < faces_.size(); ++f)
+      for (auto k = 0; k < 3; ++k) {
+        auto i = ibuf[faces_[f] * 3 + k];
+        auto [it, inserted] = map.try_emplace(i, sources.size());
+        if (inserted) sources.push_back(i);
+        indices[f * 3 + k] = it->second;
+      }
+  }
+
+  void build_vertices() const {
+    if (f2v_.empty() && !faces_.empty()) remap(parent_->f2v, vertices_, f2v_);
+  }
+
+  const MeshT* parent_;
+  std::span<const Index> faces_;
+
+  mutable std::vector<Index> vertices_;
+  mutable std::vector<Index> f2v_;
+};
+
+using Submesh = BasicSubmesh<>;
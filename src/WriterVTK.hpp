@@ -1,12 +1,15 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -38,6 +41,159 @@ class WriterVTK {
     }
   }
 
+  // Legacy format with the buffers written as big-endian raw blocks.
+  bool write_binary(std::string_view filepath,
+                    std::string_view header = std::string_view{}) {
+    std::ofstream ofs(std::string{filepath}, std::ios::binary);
+
+    if (!ofs.is_open()) {
+      std::cerr << "WARNING: cannot open file " << filepath << "\n";
+      return false;
+    }
+
+    ofs << "# vtk DataFile Version 3.0\n"
+        << (header.empty() ? "default header" : header)
+        << "\nBINARY\nDATASET UNSTRUCTURED_GRID\n";
+
+    ofs << "POINTS " << get_num_points() << " double\n";
+    write_points(ofs, true);
+    ofs << '\n';
+
+    uint64_t total_size = 0;
+    uint64_t list_size = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+      list_size += cells[i].second * (1 + get_cell_num_points(cell_types[i]));
+      total_size += cells[i].second;
+    }
+
+    ofs << "CELLS " << total_size << ' ' << list_size << '\n';
+    for (size_t i = 0; i < cells.size(); ++i) {
+      const auto [ptr, size] = cells[i];
+      const int num_points = get_cell_num_points(cell_types[i]);
+      write_generated<int32_t>(ofs, size * (1 + num_points), true, [&](auto j) {
+        auto c = j / (1 + num_points);
+        auto p = j % (1 + num_points);
+        return p == 0 ? num_points : ptr[c * num_points + p - 1];
+      });
+    }
+    ofs << '\n';
+
+    ofs << "CELL_TYPES " << total_size << '\n';
+    for (size_t i = 0; i < cells.size(); ++i)
+      write_generated<int32_t>(ofs, cells[i].second, true,
+                               [&](auto) { return cell_types[i]; });
+    ofs << '\n';
+
+    for (size_t i = 0; i < scalars.size(); ++i) {
+      const auto [ptr, size] = scalars[i];
+      ofs << get_c_str_type(scalar_types[i]) << "_DATA " << size << '\n';
+      ofs << "SCALARS scalar_data" << i << " double\n";
+      ofs << "LOOKUP_TABLE default\n";
+      write_raw(ofs, ptr, size, true);
+      ofs << '\n';
+    }
+
+    return static_cast<bool>(ofs);
+  }
+
+  // XML unstructured grid (.vtu) with all arrays in an appended raw section,
+  // each array is preceded by its size in bytes as a 64-bit integer.
+  bool write_xml(std::string_view filepath) {
+    std::ofstream ofs(std::string{filepath}, std::ios::binary);
+
+    if (!ofs.is_open()) {
+      std::cerr << "WARNING: cannot open file " << filepath << "\n";
+      return false;
+    }
+
+    uint64_t num_points = get_num_points();
+    uint64_t num_cells = 0;
+    uint64_t num_indices = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+      num_cells += cells[i].second;
+      num_indices += cells[i].second * get_cell_num_points(cell_types[i]);
+    }
+
+    // Offsets of the arrays inside the appended section.
+    uint64_t offset = 0;
+    const auto next_offset = [&](uint64_t num_bytes) {
+      auto o = offset;
+      offset += sizeof(uint64_t) + num_bytes;
+      return o;
+    };
+
+    ofs << "<?xml version=\"1.0\"?>\n"
+        << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\""
+        << (std::endian::native == std::endian::little ? "LittleEndian"
+                                                        : "BigEndian")
+        << "\" header_type=\"UInt64\">\n"
+        << "<UnstructuredGrid>\n"
+        << "<Piece NumberOfPoints=\"" << num_points << "\" NumberOfCells=\""
+        << num_cells << "\">\n";
+
+    ofs << "<Points>\n<DataArray type=\"Float64\" NumberOfComponents=\"3\" "
+           "format=\"appended\" offset=\""
+        << next_offset(num_points * 3 * sizeof(double)) << "\"/>\n</Points>\n";
+
+    ofs << "<Cells>\n";
+    ofs << "<DataArray type=\"Int32\" Name=\"connectivity\" "
+           "format=\"appended\" offset=\""
+        << next_offset(num_indices * sizeof(int32_t)) << "\"/>\n";
+    ofs << "<DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" "
+           "offset=\""
+        << next_offset(num_cells * sizeof(int64_t)) << "\"/>\n";
+    ofs << "<DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" "
+           "offset=\""
+        << next_offset(num_cells * sizeof(uint8_t)) << "\"/>\n";
+    ofs << "</Cells>\n";
+
+    for (auto type : {POINT, CELL}) {
+      ofs << (type == POINT ? "<PointData>\n" : "<CellData>\n");
+      for (size_t i = 0; i < scalars.size(); ++i)
+        if (scalar_types[i] == type)
+          ofs << "<DataArray type=\"Float64\" Name=\"scalar_data" << i
+              << "\" format=\"appended\" offset=\""
+              << next_offset(scalars[i].second * sizeof(double)) << "\"/>\n";
+      ofs << (type == POINT ? "</PointData>\n" : "</CellData>\n");
+    }
+
+    ofs << "</Piece>\n</UnstructuredGrid>\n<AppendedData encoding=\"raw\">\n_";
+
+    // Keep the same order of the offsets.
+    write_size(ofs, num_points * 3 * sizeof(double));
+    write_points(ofs, false);
+
+    write_size(ofs, num_indices * sizeof(int32_t));
+    for (size_t i = 0; i < cells.size(); ++i)
+      write_raw(ofs, cells[i].first,
+                cells[i].second * get_cell_num_points(cell_types[i]), false);
+
+    write_size(ofs, num_cells * sizeof(int64_t));
+    int64_t cell_offset = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+      const int64_t num_points = get_cell_num_points(cell_types[i]);
+      write_generated<int64_t>(ofs, cells[i].second, false, [&](auto) {
+        return cell_offset += num_points;
+      });
+    }
+
+    write_size(ofs, num_cells * sizeof(uint8_t));
+    for (size_t i = 0; i < cells.size(); ++i)
+      write_generated<uint8_t>(ofs, cells[i].second, false,
+                               [&](auto) { return cell_types[i]; });
+
+    for (auto type : {POINT, CELL})
+      for (size_t i = 0; i < scalars.size(); ++i)
+        if (scalar_types[i] == type) {
+          write_size(ofs, scalars[i].second * sizeof(double));
+          write_raw(ofs, scalars[i].first, scalars[i].second, false);
+        }
+
+    ofs << "\n</AppendedData>\n</VTKFile>\n";
+
+    return static_cast<bool>(ofs);
+  }
+
   void add_point_buffer(const double* ptr, uint64_t size, int dim) {
     assert(ptr);
     assert(size);
@@ -51,7 +207,7 @@ class WriterVTK {
     cells.emplace_back(ptr, size);
     cell_types.push_back(cell_type);
   }
-  
+
   void add_scalar_buffer(const double* ptr, uint64_t size, int scalar_type) {
     assert(ptr);
     assert(size);
@@ -79,12 +235,12 @@ class WriterVTK {
     if (!ofs) return false;
 
     uint64_t total_size = 0;
-    for (const auto [_, size] : points) total_size += size;
+    for (const auto& [_, size] : points) total_size += size;
 
     ofs << "POINTS " << total_size << ' ' << "double\n";
 
     size_t i = 0;
-    for (const auto [ptr, size] : points) {
+    for (const auto& [ptr, size] : points) {
       const int dim = point_dimensions[i++];
       for (size_t p = 0; p < size; ++p) {
         ofs << ptr[dim * p] << ' ' << ptr[dim * p + 1] << ' ';
@@ -105,7 +261,7 @@ class WriterVTK {
     uint64_t list_size{0};
 
     size_t i = 0;
-    for (const auto [_, size] : cells) {
+    for (const auto& [_, size] : cells) {
       static_cast<void>(_);
       const auto num_points = get_cell_num_points(cell_types[i++]);
       list_size += size * (1 + num_points);
@@ -140,7 +296,7 @@ class WriterVTK {
     if (!ofs) return false;
 
     size_t i = 0;
-    for (const auto [ptr, size] : scalars) {
+    for (const auto& [ptr, size] : scalars) {
       auto type = scalar_types[i];
 
       ofs << get_c_str_type(type) << "_DATA " << size << '\n';
@@ -155,6 +311,69 @@ class WriterVTK {
     return true;
   }
 
+  uint64_t get_num_points() const {
+    uint64_t total_size = 0;
+    for (const auto& [_, size] : points) total_size += size;
+    return total_size;
+  }
+
+  // Write points always with 3 coordinates.
+  void write_points(std::ofstream& ofs, bool big_endian) {
+    for (size_t i = 0; i < points.size(); ++i) {
+      const auto [ptr, size] = points[i];
+      const size_t dim = point_dimensions[i];
+      if (dim == 3)
+        write_raw(ofs, ptr, size * 3, big_endian);
+      else
+        write_generated<double>(ofs, size * 3, big_endian, [&](auto j) {
+          return j % 3 < dim ? ptr[j / 3 * dim + j % 3] : 0.0;
+        });
+    }
+  }
+
+  void write_size(std::ofstream& ofs, uint64_t num_bytes) {
+    ofs.write(reinterpret_cast<const char*>(&num_bytes), sizeof(num_bytes));
+  }
+
+  template <typename T>
+  static T swap_bytes(T x) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &x, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+    std::memcpy(&x, bytes, sizeof(T));
+    return x;
+  }
+
+  // Write count values of type T given by generator(index) through a fixed
+  // size staging buffer, optionally converting to big-endian.
+  template <typename T, typename Generator>
+  void write_generated(std::ofstream& ofs, uint64_t count, bool big_endian,
+                       Generator&& generator) {
+    constexpr uint64_t CHUNK_SIZE = 1 << 16;
+    const auto swap =
+        big_endian && std::endian::native == std::endian::little;
+
+    std::vector<T> buf(std::min(count, CHUNK_SIZE));
+    for (uint64_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+      auto size = std::min(CHUNK_SIZE, count - begin);
+      for (uint64_t j = 0; j < size; ++j) {
+        auto x = static_cast<T>(generator(begin + j));
+        buf[j] = swap ? swap_bytes(x) : x;
+      }
+      ofs.write(reinterpret_cast<const char*>(buf.data()), size * sizeof(T));
+    }
+  }
+
+  // Write a buffer as is if the byte order allows it.
+  template <typename T>
+  void write_raw(std::ofstream& ofs, const T* ptr, uint64_t count,
+                 bool big_endian) {
+    if (big_endian && std::endian::native == std::endian::little)
+      write_generated<T>(ofs, count, true, [&](auto j) { return ptr[j]; });
+    else
+      ofs.write(reinterpret_cast<const char*>(ptr), count * sizeof(T));
+  }
+
   const char* get_c_str_type(int type) {
     if (type == POINT) return "POINT";
     if (type == CELL) return "CELL";
@@ -6,6 +6,7 @@
 #include <utility>
 #include <vector>
 
+#include "CornerTable.hpp"
 #include "Mesh.hpp"
 
 // clang-format off.
@@ -34,9 +35,10 @@
 // v2v[t] = [x u x x v x x x].
 // v2v[p or q or r] = [x x v=u x x].
 // clang-format on
-static void collapse_edge(Mesh& m, int e, const double* x,
-                          std::vector<char>& is_boundary_edge,
-                          std::vector<char>& is_boundary_vertex) {
+template <typename Scalar, typename Index>
+void collapse_edge(BasicMesh<Scalar, Index>& m, Index e, const double* x,
+                   std::vector<char>& is_boundary_edge,
+                   std::vector<char>& is_boundary_vertex) {
   assert(e >= 0);
   assert(!m.edel[e]);
 
@@ -64,7 +66,7 @@ static void collapse_edge(Mesh& m, int e, const double* x,
   assert(f1 == -1 || !m.fdel[f1]);
 
   // Get flap vertices.
-  const int* p = &m.f2v[f0 * 3];
+  const Index* p = &m.f2v[f0 * 3];
   while (*p == v0 || *p == v1) ++p;
   assert(p < &m.f2v[f0 * 3] + 3);
   auto vf0 = *p;
@@ -92,6 +94,12 @@ static void collapse_edge(Mesh& m, int e, const double* x,
   m.fdel[f0] = true;
   if (f1 != -1) m.fdel[f1] = true;
 
+  // Make room for what is appended to the rows of v0 so that no row moves
+  // while iterating over the rows of v1.
+  m.v2f.reserve(v0, m.v2f[v1].size());
+  m.v2v.reserve(v0, m.v2v[v1].size());
+  m.v2e.reserve(v0, m.v2e[v1].size());
+
   // Update face to vertex connectivity.
   for (auto f : m.v2f[v1]) {
     // Do not check flaps as they have been deleted already.
@@ -102,7 +110,7 @@ static void collapse_edge(Mesh& m, int e, const double* x,
     *p = v0;
     // Update vertex to face connectivity (no more than 2 faces for manifold
     // meshes).
-    m.v2f[v0].push_back(f);
+    m.v2f.push_back(v0, f);
   }
 
   // Update vertex to vertex connectivity.
@@ -110,7 +118,7 @@ static void collapse_edge(Mesh& m, int e, const double* x,
     if (v == v0 || v == vf0 || v == vf1 || m.vdel[v]) continue;
 
     // WARNING: Collapses with more than 2 common neighbors are rejected.
-    m.v2v[v0].push_back(v);
+    m.v2v.push_back(v0, v);
     // Replace vertices.
     for (auto& vv : m.v2v[v]) {
       if (m.vdel[vv]) continue;
@@ -127,18 +135,18 @@ static void collapse_edge(Mesh& m, int e, const double* x,
   // Take care of edges and edge flaps.
   m.edel[e] = true;
   // Pointers to the flaps for the surviving edges (can point to null face -1).
-  int* p0 = nullptr;
+  Index* p0 = nullptr;
   // Unset if vf1 is -1 and f1 is -1.
-  int* p1 = nullptr;
+  Index* p1 = nullptr;
 
   // The two surviving edges of the two flaps.
-  auto ef0 = -1;
-  auto ef1 = -1;
+  Index ef0 = -1;
+  Index ef1 = -1;
 
   // The two flaps different from f0 and f1 of the two surviving edges (can be
   // -1).
-  auto ff0 = -1;
-  auto ff1 = -1;
+  Index ff0 = -1;
+  Index ff1 = -1;
 
   for (auto ee : m.v2e[v0]) {
     if (m.edel[ee]) continue;
@@ -221,7 +229,90 @@ static void collapse_edge(Mesh& m, int e, const double* x,
       else
         assert(false);
 
-      m.v2e[v0].push_back(ee);
+      m.v2e.push_back(v0, ee);
     }
   }
 }
+
+// clang-format off
+// Same collapse on the corner table for the edge faced by corner c, the vertex
+// v = f2v[prev(c)] is merged into u = f2v[next(c)]:
+//     s
+//  a /c\ b
+//   v_____u
+//    \ d /
+//     \t/
+// Faces f = face(c), g = face(d) are removed. The corners of v outside the
+// flaps are renamed to u, then the outer opposites of each flap (a = o[next(c)]
+// and b = o[prev(c)] for f) become opposite of each other. Only f2v, o and vc
+// are touched and the work is O(valence) with no allocation.
+// clang-format on
+template <typename Scalar, typename Index>
+void collapse_edge(BasicMesh<Scalar, Index>& m, BasicCornerTable<Index>& ct,
+                   Index c, const double* x) {
+  using CT = BasicCornerTable<Index>;
+
+  assert(c >= 0);
+  assert(!m.fdel[CT::face(c)]);
+
+  auto d = ct.o[c];
+  auto f0 = CT::face(c);
+  auto f1 = d == -1 ? Index{-1} : CT::face(d);
+
+  // Get the edge and flap vertices.
+  auto v0 = m.f2v[CT::next(c)];
+  auto v1 = m.f2v[CT::prev(c)];
+  auto vf0 = m.f2v[c];
+  auto vf1 = d == -1 ? Index{-1} : m.f2v[d];
+
+  assert(v0 != v1);
+  assert(!m.vdel[v0]);
+  assert(!m.vdel[v1]);
+  assert(vf0 != vf1);
+  assert(f1 == -1 || !m.fdel[f1]);
+  assert(d == -1 || (m.f2v[CT::next(d)] == v1 && m.f2v[CT::prev(d)] == v0));
+
+  // Update coordinates if specified.
+  if (x) std::copy(x, x + 3, &m.v[v0 * 3]);
+
+  // Rename v1 to v0 while the one-ring of v1 can still be swung.
+  ct.for_each_corner(v1, [&](auto e) {
+    if (CT::face(e) != f0 && CT::face(e) != f1) m.f2v[e] = v0;
+  });
+
+  // Glue the two outer opposites of a flap, return the surviving corners at
+  // the flap vertex and at v0 (-1 if none).
+  const auto glue = [&](auto e) {
+    auto a = ct.o[CT::next(e)];
+    auto b = ct.o[CT::prev(e)];
+    if (a != -1) ct.o[a] = b;
+    if (b != -1) ct.o[b] = a;
+    return std::make_pair(
+        a != -1 ? CT::next(a) : b != -1 ? CT::prev(b) : Index{-1},
+        a != -1 ? CT::prev(a) : b != -1 ? CT::next(b) : Index{-1});
+  };
+
+  auto [cf0, c0] = glue(c);
+  auto [cf1, c1] = d == -1 ? std::make_pair(Index{-1}, Index{-1}) : glue(d);
+
+  // Delete flaps and vertex.
+  m.fdel[f0] = true;
+  if (f1 != -1) m.fdel[f1] = true;
+  m.vdel[v1] = true;
+  ct.vc[v1] = -1;
+
+  // The corner of a vertex may have been deleted and its boundary may have
+  // changed, a vertex left with no corner is deleted.
+  const auto fix = [&](auto v, auto c) {
+    if (c != -1) {
+      ct.fix_vertex_corner(v, c);
+    } else {
+      ct.vc[v] = -1;
+      m.vdel[v] = true;
+    }
+  };
+
+  fix(v0, c0 != -1 ? c0 : c1);
+  fix(vf0, cf0);
+  if (vf1 != -1) fix(vf1, cf1);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#define _USE_MATH_DEFINES
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "BucketQueue.hpp"
+#include "IndexedHeap.hpp"
+#include "Mesh.hpp"
+#include "Quadric.hpp"
+#include "collapse_edge.hpp"
+#include "get_optimal_position.hpp"
+#include "make_edge_heap.hpp"
+#include "make_vertex_quadrics.hpp"
+#include "test_collapse_boundaries.hpp"
+#include "test_collapse_normal_flipping.hpp"
+#include "test_collapse_shared_neighbors.hpp"
+#include "to_vector3d.hpp"
+
+// Collapse edges in order of increasing quadric error until the mesh has at
+// most target_num_faces faces or no more collapses are possible. The mesh must
+// have its connectivities, deletion flags and face normals and areas built,
+// which are all kept up to date. Edges touching a vertex flagged in is_locked
+// (if given) are never collapsed. The queue is exact by default, BucketQueue
+// trades a slightly worse order for cheaper updates. Returns the number of
+// remaining faces.
+template <typename Scalar, typename Index,
+          typename Queue = IndexedHeap<Index>>
+auto decimate(BasicMesh<Scalar, Index>& m,
+              std::type_identity_t<Index> target_num_faces,
+              std::vector<char>& is_boundary_edge,
+              std::vector<char>& is_boundary_vertex,
+              const std::vector<char>& is_locked = {}) {
+  assert(is_locked.empty() || is_locked.size() == m.num_vertices());
+
+  auto vq = make_vertex_quadrics(m, is_boundary_edge, is_boundary_vertex);
+
+  Queue eh;
+  std::vector<Eigen::Vector3d> xs;
+
+  make_edge_heap(m, vq, eh, xs);
+
+  auto num_faces = static_cast<Index>(
+      std::count(m.fdel.begin(), m.fdel.end(), false));
+
+  for (auto i = 0; num_faces > target_num_faces && !eh.empty(); ++i) {
+    auto [c, e] = eh.top();
+    eh.pop();
+    const auto* x = &(xs[e][0]);
+    auto v0 = m.e2v[e * 2];
+    auto v1 = m.e2v[e * 2 + 1];
+
+    std::vector<std::tuple<Index, Eigen::Vector3d, double>> ns;
+
+    // Put less expensive test first.
+    if (m.edel[e] ||
+        (!is_locked.empty() && (is_locked[v0] || is_locked[v1])) ||
+        !test_collapse_boundaries(m, e, is_boundary_edge,
+                                  is_boundary_vertex) ||
+        !test_collapse_shared_neighbors(m, e, is_boundary_edge) ||
+        !test_collapse_normal_flipping(m, e, x, std::cos(M_PI / 3.0), ns)) {
+      // std::cerr << "WARNING: Collapse of edge " << e
+      //           << " rejected. Deleted: " << static_cast<bool>(m.edel[e])
+      //           << '\n';
+    } else {
+      // std::cout << "Edge: " << e << '\n';
+      // std::cout << "Cost: " << c << '\n';
+      // std::cout << "Position: " << xs[e].transpose() << '\n';
+
+      // debug
+      // writeVTK_edge_patch("edge_patch.vtk", m, e);
+      collapse_edge(m, e, x, is_boundary_edge, is_boundary_vertex);
+      // writeVTK_vertex_patch("vertex_patch.vtk", m, v0);
+
+      // Update number of faces.
+      num_faces -= is_boundary_edge[e] ? 1 : 2;
+
+      // Update precomputed normals and areas.
+      for (const auto& [f, n, a] : ns) {
+        std::copy(&n[0], &n[0] + 3, &m.fn[f * 3]);
+        m.fa[f] = a;
+      }
+
+      // Update quadric of surviving vertex by accumulating error.
+      vq[v0] += vq[v1];
+
+      // Update queue. The edges deleted by the collapse were all around v0
+      // or v1.
+      for (auto e : m.v2e[v1])
+        if (m.edel[e]) eh.remove(e);
+
+      for (auto e : m.v2e[v0]) {
+        if (m.edel[e]) {
+          eh.remove(e);
+          continue;
+        }
+
+        auto v1 = m.e2v[e * 2] == v0 ? m.e2v[e * 2 + 1] : m.e2v[e * 2];
+        assert(!m.vdel[v1]);
+
+        // Sum quadrics.
+        auto q = vq[v0] + vq[v1];
+
+        // Compute position.
+        Eigen::Vector3d x;
+        if (!get_optimal_position(q, x)) {
+          std::cout << "WARNING: Optimal position failed.\n";
+          Eigen::Vector3d x0 = to_vector3d(&m.v[v0 * 3]);
+          Eigen::Vector3d x1 = to_vector3d(&m.v[v1 * 3]);
+          x = get_edge_position(q, x0, x1);
+        }
+
+        xs[e] = x;
+        eh.push(e, std::abs(q(x)));
+      }
+    }
+  }
+
+  return num_faces;
+}
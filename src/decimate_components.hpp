@@ -0,0 +1,185 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "BucketQueue.hpp"
+#include "Mesh.hpp"
+#include "Submesh.hpp"
+#include "decimate.hpp"
+#include "decimate_corner_table.hpp"
+#include "find_boundary_edges.hpp"
+#include "find_instances.hpp"
+#include "make_compressed.hpp"
+#include "make_edges.hpp"
+#include "make_face_normals_and_areas.hpp"
+#include "make_topology.hpp"
+#include "parallel_task.hpp"
+#include "to_vector3d.hpp"
+
+// Decimate every connected component concurrently and merge the results into
+// out (positions, faces, face normals and areas, texture coordinates and
+// normals with their faces), which can be the parent of the views. The target
+// is split among the components in proportion to their number of faces, with
+// at least 4 faces per component (or all of them if it has fewer): the small
+// components get their minimum first and the others share what is left, so
+// the sum only exceeds the target when the minimums alone do, which is
+// reported. Threads pick the components largest first from a shared counter,
+// so that a few big ones do not end up on the same thread,
+// copy them out of the parent and run all the steps serially on their thread.
+// If instances are given (see find_instances) only the prototypes are
+// decimated and their result is moved onto each of their copies. With
+// use_bucket_queue the collapses are ordered by a BucketQueue.
+template <typename Scalar, typename Index>
+void decimate_components(const std::vector<BasicSubmesh<Scalar, Index>>& views,
+                         std::type_identity_t<Index> target_num_faces,
+                         bool use_corner_table, bool use_bucket_queue,
+                         BasicMesh<Scalar, Index>& out,
+                         const std::vector<Instance<Index>>& instances = {}) {
+  assert(instances.empty() || instances.size() == views.size());
+
+  auto num_components = views.size();
+  const auto prototype = [&](size_t i) -> size_t {
+    return instances.empty() ? i : instances[i].prototype;
+  };
+
+  size_t num_faces = 0;
+  for (const auto& view : views) num_faces += view.num_faces();
+
+  // Smallest components first.
+  std::vector<size_t> order(num_components);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](auto l, auto r) {
+    return views[l].num_faces() < views[r].num_faces();
+  });
+
+  std::vector<Index> targets(num_components);
+  {
+    double remaining_target = target_num_faces;
+    auto remaining_faces = num_faces;
+    size_t min_num_faces = 0;
+    for (auto i : order) {
+      auto n = views[i].num_faces();
+      auto min = std::min<size_t>(4, n);
+      auto share = remaining_target * n / remaining_faces;
+      targets[i] = std::max<Index>(min, std::llround(share));
+      remaining_target -= targets[i];
+      remaining_faces -= n;
+      min_num_faces += min;
+    }
+    if (min_num_faces > static_cast<size_t>(target_num_faces))
+      std::cout << "WARNING: The " << num_components
+                << " components keep at least " << min_num_faces
+                << " faces, more than the target.\n";
+  }
+
+  order.clear();
+  for (size_t i = 0; i < num_components; ++i)
+    if (prototype(i) == i) order.push_back(i);
+  std::stable_sort(order.begin(), order.end(), [&](auto l, auto r) {
+    return views[l].num_faces() > views[r].num_faces();
+  });
+
+  std::vector<BasicMesh<Scalar, Index>> ms(num_components);
+  std::atomic<size_t> next = 0;
+  const auto task = [&](auto, auto, auto) {
+    for (auto i = next++; i < order.size(); i = next++) {
+      auto& m = ms[order[i]];
+      m = views[order[i]].compacted();
+      auto target = targets[order[i]];
+
+      make_face_normals_and_areas(m);
+      m.vdel.assign(m.num_vertices(), false);
+      m.fdel.assign(m.num_faces(), false);
+
+      if (use_corner_table) {
+        if (use_bucket_queue)
+          decimate_corner_table<Scalar, Index, BucketQueue<Index>>(m, target);
+        else
+          decimate_corner_table(m, target);
+      } else {
+        make_topology(m, false);
+        make_edges(m);
+        m.edel.assign(m.num_edges(), false);
+
+        std::vector<char> is_boundary_edge(m.num_edges(), false);
+        find_boundary_edges(m, is_boundary_edge);
+
+        std::vector<char> is_boundary_vertex(m.num_vertices(), false);
+        for (size_t e = 0; e < m.num_edges(); ++e) {
+          if (is_boundary_edge[e]) {
+            is_boundary_vertex[m.e2v[e * 2]] = true;
+            is_boundary_vertex[m.e2v[e * 2 + 1]] = true;
+          }
+        }
+
+        if (use_bucket_queue)
+          decimate<Scalar, Index, BucketQueue<Index>>(
+              m, target, is_boundary_edge, is_boundary_vertex);
+        else
+          decimate(m, target, is_boundary_edge, is_boundary_vertex);
+      }
+
+      make_compressed(m);
+      // Only what is merged is kept.
+      BasicMesh<Scalar, Index> mc;
+      mc.v.swap(m.v);
+      mc.f2v.swap(m.f2v);
+      mc.fn.swap(m.fn);
+      mc.fa.swap(m.fa);
+      mc.t.swap(m.t);
+      mc.f2t.swap(m.f2t);
+      mc.n.swap(m.n);
+      mc.f2n.swap(m.f2n);
+      m = std::move(mc);
+    }
+  };
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0u, utl::NUM_HARDWARE_THREADS,
+                     task);
+
+  // Merge.
+  out = {};
+  for (size_t i = 0; i < num_components; ++i) {
+    const auto& mc = ms[prototype(i)];
+    auto offset = static_cast<Index>(out.num_vertices());
+    out.v.insert(out.v.end(), mc.v.begin(), mc.v.end());
+    for (auto v : mc.f2v) out.f2v.push_back(v + offset);
+    out.fn.insert(out.fn.end(), mc.fn.begin(), mc.fn.end());
+    out.fa.insert(out.fa.end(), mc.fa.begin(), mc.fa.end());
+    auto t_offset = static_cast<Index>(out.num_texture());
+    out.t.insert(out.t.end(), mc.t.begin(), mc.t.end());
+    for (auto k : mc.f2t) out.f2t.push_back(k + t_offset);
+    auto n_offset = static_cast<Index>(out.num_normals());
+    out.n.insert(out.n.end(), mc.n.begin(), mc.n.end());
+    for (auto k : mc.f2n) out.f2n.push_back(k + n_offset);
+
+    if (prototype(i) == i) continue;
+
+    // Move the copy onto the instance, normals only rotate.
+    const auto& [p, r, t] = instances[i];
+    for (size_t k = offset * 3; k < out.v.size(); k += 3) {
+      Eigen::Vector3d x = r * to_vector3d(&out.v[k]) + t;
+      Eigen::Map<Eigen::Matrix<Scalar, 3, 1>>{&out.v[k]} =
+          x.template cast<Scalar>();
+    }
+    const auto rotate = [&](auto& ns, size_t begin) {
+      for (auto k = begin; k < ns.size(); k += 3) {
+        Eigen::Vector3d n = r * to_vector3d(&ns[k]);
+        Eigen::Map<Eigen::Matrix<Scalar, 3, 1>>{&ns[k]} =
+            n.template cast<Scalar>();
+      }
+    };
+    rotate(out.fn, out.fn.size() - mc.fn.size());
+    rotate(out.n, n_offset * 3);
+  }
+  out.vdel.assign(out.num_vertices(), false);
+  out.fdel.assign(out.num_faces(), false);
+}
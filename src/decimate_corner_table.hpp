@@ -0,0 +1,183 @@
+#pragma once
+
+#define _USE_MATH_DEFINES
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "BucketQueue.hpp"
+#include "CornerTable.hpp"
+#include "IndexedHeap.hpp"
+#include "Mesh.hpp"
+#include "Quadric.hpp"
+#include "collapse_edge.hpp"
+#include "get_optimal_position.hpp"
+#include "make_vertex_quadrics.hpp"
+#include "parallel_task.hpp"
+#include "test_collapse_boundaries.hpp"
+#include "test_collapse_normal_flipping.hpp"
+#include "test_collapse_shared_neighbors.hpp"
+#include "to_vector3d.hpp"
+
+// Same as decimate but the mesh only needs f2v, the face normals and areas and
+// the deletion flags of vertices and faces, the connectivity being the corner
+// table built here (two ints per corner and one per vertex). Edges are keyed by
+// their canonical corner. Vertices whose corners are not all reachable by
+// swinging (non-manifold vertices) and the edges around them are left
+// untouched. The queue is picked as for decimate. Returns the number of
+// remaining faces.
+template <typename Scalar, typename Index,
+          typename Queue = IndexedHeap<Index>>
+auto decimate_corner_table(BasicMesh<Scalar, Index>& m,
+                           std::type_identity_t<Index> target_num_faces) {
+  using CT = BasicCornerTable<Index>;
+
+  CT ct;
+  make_corner_table(m, ct);
+  auto num_corners = static_cast<Index>(ct.o.size());
+
+  // Lock non-manifold vertices.
+  std::vector<char> is_locked(m.num_vertices(), false);
+  {
+    std::vector<int> num_reachable(m.num_vertices(), 0);
+    for (Index v = 0; v < static_cast<Index>(m.num_vertices()); ++v)
+      if (ct.vc[v] != -1)
+        ct.for_each_corner(v, [&](auto) { ++num_reachable[v]; });
+    for (Index c = 0; c < num_corners; ++c) --num_reachable[m.f2v[c]];
+    for (size_t v = 0; v < m.num_vertices(); ++v)
+      is_locked[v] = num_reachable[v] != 0;
+  }
+
+  auto vq = make_vertex_quadrics(m, ct);
+
+  // Optimal position and cost of the edge faced by corner c.
+  const auto evaluate = [&](auto c, auto& x) {
+    auto v0 = m.f2v[CT::next(c)];
+    auto v1 = m.f2v[CT::prev(c)];
+
+    // Sum quadrics.
+    auto q = vq[v0] + vq[v1];
+
+    // Compute position.
+    if (!get_optimal_position(q, x)) {
+      std::cout << "WARNING: Optimal position failed.\n";
+      Eigen::Vector3d x0 = to_vector3d(&m.v[v0 * 3]);
+      Eigen::Vector3d x1 = to_vector3d(&m.v[v1 * 3]);
+      x = get_edge_position(q, x0, x1);
+    }
+
+    // Cost is always positive up to floating point arithmetic.
+    return std::abs(q(x));
+  };
+
+  // One entry per edge.
+  std::vector<Index> cs;
+  for (Index c = 0; c < num_corners; ++c)
+    if (!m.fdel[CT::face(c)] && ct.canonical(c) == c) cs.push_back(c);
+
+  std::vector<typename Queue::Entry> es(cs.size());
+  std::vector<Eigen::Vector3d> xs(num_corners);
+  {
+    // Same as evaluate by batches of edges.
+    const auto task = [&](auto, auto i0, auto end) {
+      Quadric qs[OPTIMAL_POSITION_BATCH];
+      Eigen::Vector3d bxs[OPTIMAL_POSITION_BATCH];
+      char is_solved[OPTIMAL_POSITION_BATCH];
+
+      for (; i0 < end; i0 += OPTIMAL_POSITION_BATCH) {
+        auto n = static_cast<int>(
+            std::min<size_t>(OPTIMAL_POSITION_BATCH, end - i0));
+
+        for (int i = 0; i < n; ++i) {
+          auto c = cs[i0 + i];
+          qs[i] = vq[m.f2v[CT::next(c)]] + vq[m.f2v[CT::prev(c)]];
+        }
+
+        get_optimal_positions(qs, n, bxs, is_solved);
+
+        for (int i = 0; i < n; ++i) {
+          auto c = cs[i0 + i];
+          if (is_solved[i]) {
+            xs[c] = bxs[i];
+            es[i0 + i] = {std::abs(qs[i](xs[c])), c};
+          } else {
+            es[i0 + i] = {evaluate(c, xs[c]), c};
+          }
+        }
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, cs.size(), task);
+  }
+
+  Queue eh(num_corners);
+  eh.assign(std::move(es));
+
+  auto num_faces = static_cast<Index>(
+      std::count(m.fdel.begin(), m.fdel.end(), false));
+
+  std::vector<std::tuple<Index, Eigen::Vector3d, double>> ns;
+
+  while (num_faces > target_num_faces && !eh.empty()) {
+    auto [cost, c] = eh.top();
+    eh.pop();
+
+    const auto* x = &(xs[c][0]);
+    auto v0 = m.f2v[CT::next(c)];
+    auto v1 = m.f2v[CT::prev(c)];
+    auto vf0 = m.f2v[c];
+    auto vf1 = ct.o[c] == -1 ? Index{-1} : m.f2v[ct.o[c]];
+
+    ns.clear();
+
+    // Put less expensive test first. Flap vertices are checked too as a
+    // locked one could lose the corner it is reached from.
+    if (m.fdel[CT::face(c)] || ct.canonical(c) != c ||
+        is_locked[v0] || is_locked[v1] || is_locked[vf0] ||
+        (vf1 != -1 && is_locked[vf1]) || !test_collapse_boundaries(m, ct, c) ||
+        !test_collapse_shared_neighbors(m, ct, c) ||
+        !test_collapse_normal_flipping(m, ct, c, x, std::cos(M_PI / 3.0),
+                                       ns))
+      continue;
+
+    auto f1 = ct.o[c] == -1 ? Index{-1} : CT::face(ct.o[c]);
+    num_faces -= f1 == -1 ? 1 : 2;
+    collapse_edge(m, ct, c, x);
+
+    // Remove the edges faced by the deleted flaps.
+    for (auto f : {CT::face(c), f1})
+      if (f != -1)
+        for (auto e = f * 3; e < f * 3 + 3; ++e) eh.remove(e);
+
+    // Update precomputed normals and areas.
+    for (const auto& [f, n, a] : ns) {
+      std::copy(&n[0], &n[0] + 3, &m.fn[f * 3]);
+      m.fa[f] = a;
+    }
+
+    // Update quadric of surviving vertex by accumulating error.
+    vq[v0] += vq[v1];
+
+    if (m.vdel[v0]) continue;
+
+    // Update queue. Every edge around v0 is faced by the previous corner of
+    // some corner at v0, except the last one when v0 is on the boundary.
+    const auto push = [&](auto e) {
+      e = ct.canonical(e);
+      // The other corner of an edge glued by the collapse may be queued.
+      if (ct.o[e] != -1) eh.remove(ct.o[e]);
+      eh.push(e, evaluate(e, xs[e]));
+    };
+
+    ct.for_each_corner(v0, [&](auto e) {
+      push(CT::prev(e));
+      if (ct.o[CT::next(e)] == -1) push(CT::next(e));
+    });
+  }
+
+  return num_faces;
+}
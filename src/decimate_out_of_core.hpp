@@ -0,0 +1,345 @@
+#pragma once
+
+#include <robin_hood.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BucketQueue.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include "compress_buffer.hpp"
+#include "decimate.hpp"
+#include "diagnose_faces.hpp"
+#include "find_boundary_edges.hpp"
+#include "make_compressed.hpp"
+#include "make_edges.hpp"
+#include "make_face_normals_and_areas.hpp"
+#include "make_topology.hpp"
+#include "readOBJ.hpp"
+
+namespace ooc {
+
+// Rough in-core footprint of a triangle once all the connectivities, the
+// quadrics and the queue are built, used to size the cells.
+inline constexpr size_t BYTES_PER_FACE = 512;
+
+// Remove the faces the collapse cannot handle, build everything decimate needs
+// and collapse down to target_num_faces.
+static void decimate_in_core(Mesh& m, int target_num_faces,
+                             bool use_bucket_queue,
+                             const std::vector<char>& is_locked = {}) {
+  auto d = diagnose_faces(m.f2v);
+  std::vector<char> fflags(m.num_faces());
+  for (size_t f = 0; f < m.num_faces(); ++f)
+    fflags[f] = d.duplicate_faces[f] || d.non_manifold_faces[f];
+  if (std::count(fflags.begin(), fflags.end(), true) > 0)
+    m.f2v.resize(3 * compress_buffer<3>(m.f2v.data(), m.num_faces(),
+                                        fflags.data()));
+
+  make_face_normals_and_areas(m);
+  make_topology(m, false);
+  make_edges(m);
+  m.vdel.assign(m.num_vertices(), false);
+  m.fdel.assign(m.num_faces(), false);
+  m.edel.assign(m.num_edges(), false);
+
+  std::vector<char> is_boundary_edge(m.num_edges(), false);
+  find_boundary_edges(m, is_boundary_edge);
+
+  std::vector<char> is_boundary_vertex(m.num_vertices(), false);
+  for (size_t e = 0; e < m.num_edges(); ++e) {
+    if (is_boundary_edge[e]) {
+      is_boundary_vertex[m.e2v[e * 2]] = true;
+      is_boundary_vertex[m.e2v[e * 2 + 1]] = true;
+    }
+  }
+
+  if (use_bucket_queue)
+    decimate<double, int, BucketQueue<int>>(
+        m, target_num_faces, is_boundary_edge, is_boundary_vertex, is_locked);
+  else
+    decimate(m, target_num_faces, is_boundary_edge, is_boundary_vertex,
+             is_locked);
+}
+
+// Faces of a cell (or a list of vertices) are appended to a file through a
+// small buffer.
+struct Bucket {
+  std::string filepath;
+  std::vector<int> buf;
+  size_t num_faces = 0;  // Number of vertices for a list of vertices.
+
+  void flush() {
+    if (buf.empty()) return;
+    std::FILE* file = std::fopen(filepath.c_str(), "ab");
+    if (!file) {
+      std::fprintf(stderr, "ERROR: Could not open \"%s\".\n", filepath.c_str());
+      std::exit(EXIT_FAILURE);
+    }
+    std::fwrite(buf.data(), sizeof(int), buf.size(), file);
+    std::fclose(file);
+    buf.clear();
+  }
+};
+
+}  // namespace ooc
+
+// Decimate an OBJ file that does not fit in memory down to target_num_faces.
+// The input is streamed twice: vertices are spilled to a raw file and faces are
+// bucketed by centroid into a uniform grid of cells, each one stored in its own
+// file. Every cell is then decimated in core with the vertices it shares with
+// other cells locked, the reduced cells are stitched on the shared vertices and
+// a final pass decimates the stitched mesh. Shared vertices are found on disk
+// by merging the sorted vertex lists of the cells. The grid is sized so that a
+// cell and the stitched mesh fit in memory_budget bytes, apart from the pages
+// of the mapped files, which the system can reclaim. use_bucket_queue is passed
+// to decimate. Returns false if no face could be read.
+static bool decimate_out_of_core(std::string_view filepath,
+                                 int target_num_faces, size_t memory_budget,
+                                 bool use_bucket_queue, Mesh& out) {
+  namespace fs = std::filesystem;
+
+  auto dir = fs::temp_directory_path() /
+             ("qslim-ooc-" + std::to_string(::getpid()));
+  fs::create_directories(dir);
+
+  // Parsed chunks take a fraction of the budget.
+  auto chunk_size = std::max<size_t>(memory_budget / 16, 1 << 20);
+
+  // Spill vertices and compute the bounding box.
+  size_t num_vertices = 0;
+  size_t num_faces = 0;
+  std::array<double, 3> min, max;
+  min.fill(std::numeric_limits<double>::max());
+  max.fill(std::numeric_limits<double>::lowest());
+  {
+    auto vpath = (dir / "vertices.bin").string();
+    std::FILE* file = std::fopen(vpath.c_str(), "wb");
+    if (!file) {
+      std::fprintf(stderr, "ERROR: Could not open \"%s\".\n", vpath.c_str());
+      std::exit(EXIT_FAILURE);
+    }
+
+    readOBJ_chunks(filepath, chunk_size, [&](const Mesh& chunk, size_t) {
+      std::fwrite(chunk.v.data(), sizeof(double), chunk.v.size(), file);
+      for (size_t v = 0; v < chunk.num_vertices(); ++v)
+        for (auto k = 0; k < 3; ++k) {
+          min[k] = std::min(min[k], chunk.v[v * 3 + k]);
+          max[k] = std::max(max[k], chunk.v[v * 3 + k]);
+        }
+      num_vertices += chunk.num_vertices();
+      num_faces += chunk.num_faces();
+    });
+
+    std::fclose(file);
+  }
+
+  if (num_faces == 0) {
+    fs::remove_all(dir);
+    return false;
+  }
+
+  // Uniform grid with enough cells for each one to fit in the budget assuming
+  // faces are spread evenly (twice as many to leave room for unevenness).
+  auto faces_per_cell =
+      std::max<size_t>(memory_budget / ooc::BYTES_PER_FACE, 1024);
+  auto num_cells_needed =
+      2 * ((num_faces + faces_per_cell - 1) / faces_per_cell);
+  int n = num_cells_needed <= 2 ? 1 : std::ceil(std::cbrt(num_cells_needed));
+  std::array<double, 3> size;
+  for (auto k = 0; k < 3; ++k) size[k] = std::max(max[k] - min[k], 1e-300) / n;
+
+  std::cout << "Out-of-core cells: " << n * n * n << '\n';
+
+  // Bucket faces.
+  std::vector<ooc::Bucket> buckets(n * n * n);
+  {
+    MappedFile vfile((dir / "vertices.bin").string());
+    const auto* x = reinterpret_cast<const double*>(vfile.data());
+
+    auto flush_size = std::max<size_t>(
+        memory_budget / (8 * sizeof(int) * buckets.size()), 1024);
+    for (size_t i = 0; i < buckets.size(); ++i)
+      buckets[i].filepath =
+          (dir / ("cell" + std::to_string(i) + ".bin")).string();
+
+    readOBJ_chunks(filepath, chunk_size, [&](const Mesh& chunk, size_t) {
+      for (size_t f = 0; f < chunk.num_faces(); ++f) {
+        const auto* fv = &chunk.f2v[f * 3];
+        if (std::any_of(fv, fv + 3, [&](auto v) {
+              return v < 0 || static_cast<size_t>(v) >= num_vertices;
+            }))
+          continue;
+
+        const auto* x0 = &x[static_cast<size_t>(fv[0]) * 3];
+        const auto* x1 = &x[static_cast<size_t>(fv[1]) * 3];
+        const auto* x2 = &x[static_cast<size_t>(fv[2]) * 3];
+
+        auto cell = 0;
+        for (auto k = 0; k < 3; ++k) {
+          auto c = (x0[k] + x1[k] + x2[k]) / 3;
+          auto i =
+              std::clamp(static_cast<int>((c - min[k]) / size[k]), 0, n - 1);
+          cell = cell * n + i;
+        }
+
+        auto& b = buckets[cell];
+        b.buf.insert(b.buf.end(), fv, fv + 3);
+        ++b.num_faces;
+        if (b.buf.size() >= flush_size) b.flush();
+      }
+    });
+
+    for (auto& b : buckets) b.flush();
+  }
+
+  // Sorted vertices of every cell, one cell in memory at a time.
+  std::vector<ooc::Bucket> cell_vertices(buckets.size());
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    if (buckets[i].num_faces == 0) continue;
+    auto& cv = cell_vertices[i];
+    cv.filepath = buckets[i].filepath + ".v";
+    {
+      MappedFile ffile(buckets[i].filepath);
+      const auto* fv = reinterpret_cast<const int*>(ffile.data());
+      cv.buf.assign(fv, fv + buckets[i].num_faces * 3);
+    }
+    std::sort(cv.buf.begin(), cv.buf.end());
+    cv.buf.erase(std::unique(cv.buf.begin(), cv.buf.end()), cv.buf.end());
+    cv.num_faces = cv.buf.size();
+    cv.flush();
+    cv.buf.shrink_to_fit();
+  }
+
+  // Vertices shared by more than one cell, found by a k-way merge of the cell
+  // lists and written in increasing order.
+  ooc::Bucket shared;
+  shared.filepath = (dir / "shared.bin").string();
+  {
+    std::deque<MappedFile> files;
+    using Head = std::pair<int, size_t>;  // Vertex, position in files.
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    std::vector<size_t> pos;
+    for (const auto& cv : cell_vertices) {
+      if (cv.num_faces == 0) continue;
+      const auto& file = files.emplace_back(cv.filepath);
+      heads.push({reinterpret_cast<const int*>(file.data())[0], pos.size()});
+      pos.push_back(0);
+    }
+
+    auto flush_size = std::max<size_t>(memory_budget / (8 * sizeof(int)), 1024);
+    while (!heads.empty()) {
+      auto v = heads.top().first;
+      size_t count = 0;
+      while (!heads.empty() && heads.top().first == v) {
+        auto i = heads.top().second;
+        heads.pop();
+        ++count;
+        const auto* vs = reinterpret_cast<const int*>(files[i].data());
+        if (++pos[i] < files[i].size() / sizeof(int))
+          heads.push({vs[pos[i]], i});
+      }
+      if (count > 1) {
+        shared.buf.push_back(v);
+        ++shared.num_faces;
+        if (shared.buf.size() >= flush_size) shared.flush();
+      }
+    }
+    shared.flush();
+  }
+  std::cout << "Shared vertices: " << shared.num_faces << '\n';
+
+  // Reduce every cell so that the stitched mesh fits in the budget.
+  auto ratio = std::min(
+      1.0, std::max<double>(target_num_faces, faces_per_cell / 2) / num_faces);
+
+  // Stitched vertices of the locked input vertices, by rank in the shared
+  // list. They all end up in the stitched mesh, which fits in the budget.
+  std::vector<int> g2s(shared.num_faces, -1);
+  {
+    MappedFile vfile((dir / "vertices.bin").string());
+    const auto* x = reinterpret_cast<const double*>(vfile.data());
+    MappedFile sfile(shared.filepath);
+    const auto* sbegin = reinterpret_cast<const int*>(sfile.data());
+    const auto* send = sbegin + shared.num_faces;
+
+    for (auto& b : buckets) {
+      if (b.num_faces == 0) continue;
+
+      Mesh m;
+      {
+        MappedFile ffile(b.filepath);
+        const auto* fv = reinterpret_cast<const int*>(ffile.data());
+        m.f2v.assign(fv, fv + b.num_faces * 3);
+      }
+
+      // Make the cell indices local.
+      std::vector<int> l2g;
+      {
+        robin_hood::unordered_flat_map<int, int> g2l;
+        for (auto& v : m.f2v) {
+          auto [it, inserted] = g2l.insert({v, static_cast<int>(l2g.size())});
+          if (inserted) {
+            l2g.push_back(v);
+            m.v.insert(m.v.end(), &x[static_cast<size_t>(v) * 3],
+                       &x[static_cast<size_t>(v) * 3] + 3);
+          }
+          v = it->second;
+        }
+      }
+
+      std::vector<char> is_locked(l2g.size());
+      for (size_t v = 0; v < l2g.size(); ++v)
+        is_locked[v] = std::binary_search(sbegin, send, l2g[v]);
+
+      auto target = static_cast<int>(std::ceil(ratio * b.num_faces));
+      ooc::decimate_in_core(m, std::max(target, 1), use_bucket_queue,
+                            is_locked);
+
+      std::vector<int> vmap;
+      make_compressed(m, &vmap);
+
+      // Stitch, locked vertices are never moved so they can be merged.
+      std::vector<int> l2s(m.num_vertices(), -1);
+      for (size_t v = 0; v < vmap.size(); ++v) {
+        if (vmap[v] == -1) continue;
+        const auto* p = &m.v[static_cast<size_t>(vmap[v]) * 3];
+        if (is_locked[v]) {
+          auto& s = g2s[std::lower_bound(sbegin, send, l2g[v]) - sbegin];
+          if (s == -1) {
+            s = out.num_vertices();
+            out.v.insert(out.v.end(), p, p + 3);
+          }
+          l2s[vmap[v]] = s;
+        } else {
+          l2s[vmap[v]] = out.num_vertices();
+          out.v.insert(out.v.end(), p, p + 3);
+        }
+      }
+
+      for (auto v : m.f2v) out.f2v.push_back(l2s[v]);
+    }
+  }
+
+  fs::remove_all(dir);
+  g2s = std::vector<int>{};
+
+  std::cout << "Stitched faces: " << out.num_faces() << '\n';
+  if (out.num_faces() == 0) return false;
+
+  ooc::decimate_in_core(out, target_num_faces, use_bucket_queue);
+  return true;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "parallel_radix_sort.hpp"
+#include "parallel_task.hpp"
+
+// Defects of a triangle soup found by diagnose_faces.
+struct FaceDiagnostics {
+  // Faces with the same vertices as an earlier face.
+  std::vector<char> duplicate_faces;
+  // Faces beyond the second one (in face order) on some edge once duplicates
+  // are ignored.
+  std::vector<char> non_manifold_faces;
+  size_t num_duplicate_faces = 0;
+  size_t num_non_manifold_faces = 0;
+  // Edges with more than two faces once duplicates are ignored.
+  size_t num_non_manifold_edges = 0;
+  // No ordered edge is used twice once duplicates are ignored.
+  bool is_oriented = true;
+  // The same, manifoldness and the boundary once non-manifold faces are
+  // ignored too.
+  bool is_oriented_after_cleanup = true;
+  bool is_edge_manifold_after_cleanup = true;
+  size_t num_boundary_edges = 0;
+  bool is_closed() const { return num_boundary_edges == 0; }
+};
+
+// Fused replacement of find_duplicate_faces, is_oriented and
+// find_non_manifold_faces (with the same results) plus boundary and closedness.
+// Every corner emits the edge it faces as (min vertex, max vertex, opposite
+// vertex), the keys are radix sorted in parallel (stably, so corners stay in
+// face order) and every run of equal edges is inspected by the thread whose
+// block it starts in. Within an edge faces with the same opposite vertex are
+// duplicates, directions tell the orientation and the count of faces the
+// manifoldness and the boundary. A second pass over the runs checks the mesh
+// left once the flagged faces are removed.
+template <typename Index>
+FaceDiagnostics diagnose_faces(const std::vector<Index>& f2v) {
+  struct HalfEdge {
+    Index v0;
+    Index v1;
+    Index opposite;
+    Index c;
+  };
+
+  const auto next = [](Index c) { return c % 3 == 2 ? c - 2 : c + 1; };
+  const auto prev = [](Index c) { return c % 3 == 0 ? c + 2 : c - 1; };
+
+  auto num_corners = static_cast<Index>(f2v.size());
+  auto num_faces = f2v.size() / 3;
+
+  FaceDiagnostics d;
+  d.duplicate_faces.assign(num_faces, false);
+  d.non_manifold_faces.assign(num_faces, false);
+
+  std::vector<HalfEdge> hs(num_corners);
+  {
+    const auto task = [&](auto, auto c, auto end) {
+      for (; c < end; ++c) {
+        auto v0 = f2v[next(c)];
+        auto v1 = f2v[prev(c)];
+        hs[c] = {std::min(v0, v1), std::max(v0, v1), f2v[c], c};
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_corners, task);
+  }
+
+  {
+    auto max_vertex = f2v.empty()
+                          ? uint64_t{0}
+                          : static_cast<uint64_t>(
+                                *std::max_element(f2v.begin(), f2v.end()));
+    int num_bytes = (std::bit_width(max_vertex) + 7) / 8;
+    const auto digit = [num_bytes](const HalfEdge& h, int d) {
+      auto k = d / num_bytes;
+      auto v =
+          static_cast<uint64_t>(k == 0 ? h.opposite : k == 1 ? h.v1 : h.v0);
+      return static_cast<size_t>((v >> (8 * (d % num_bytes))) & 0xff);
+    };
+    utl::parallel_radix_sort(utl::NUM_HARDWARE_THREADS, hs, 3 * num_bytes,
+                             digit);
+  }
+
+  const auto same_edge = [&](size_t i, size_t j) {
+    return hs[i].v0 == hs[j].v0 && hs[i].v1 == hs[j].v1;
+  };
+  // Not the first face with these vertices, compared to the previous entry as
+  // the run is sorted by opposite vertex.
+  const auto is_duplicate = [&](size_t begin, size_t i) {
+    return i > begin && hs[i].opposite == hs[i - 1].opposite &&
+           hs[i].c / 3 != hs[i - 1].c / 3;
+  };
+  // Half edges of the same face with the same opposite vertex (degenerate
+  // faces) follow each other, the face is a duplicate if any earlier face
+  // comes first.
+  const auto first_of_face = [&](size_t begin, size_t i) {
+    while (i > begin && hs[i].opposite == hs[i - 1].opposite &&
+           hs[i].c / 3 == hs[i - 1].c / 3)
+      --i;
+    return i;
+  };
+  const auto is_forward = [&](const HalfEdge& h) {
+    return f2v[next(h.c)] <= f2v[prev(h.c)];
+  };
+
+  // Visit every run of half edges on the same edge starting in the block of
+  // the thread, with run(thread, begin, end).
+  const auto for_each_run = [&](auto&& run) {
+    const auto task = [&](auto t, auto i, auto end) {
+      for (; i < end; ++i) {
+        if (i > 0 && same_edge(i, i - 1)) continue;
+        auto j = i + 1;
+        while (j < hs.size() && same_edge(i, j)) ++j;
+        run(t, i, j);
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, hs.size(), task);
+  };
+
+  struct Counts {
+    size_t num_non_manifold_edges = 0;
+    size_t num_remaining_non_manifold_edges = 0;
+    size_t num_boundary_edges = 0;
+    bool is_oriented = true;
+  };
+  std::vector<Counts> counts(std::max(utl::NUM_HARDWARE_THREADS, 1u));
+
+  // Duplicates, orientation and manifoldness.
+  for_each_run([&](auto t, auto begin, auto end) {
+    std::vector<Index> cs;
+    size_t num_forward = 0, num_backward = 0;
+    for (auto i = begin; i < end; ++i) {
+      auto dup = is_duplicate(begin, first_of_face(begin, i));
+      // Each face is flagged from the half edge of its first corner only.
+      if (hs[i].c % 3 == 0) d.duplicate_faces[hs[i].c / 3] = dup;
+      if (dup) continue;
+      cs.push_back(hs[i].c);
+      (is_forward(hs[i]) ? num_forward : num_backward) += 1;
+    }
+    if (num_forward > 1 || num_backward > 1) counts[t].is_oriented = false;
+
+    if (cs.size() > 2) {
+      ++counts[t].num_non_manifold_edges;
+      std::sort(cs.begin(), cs.end());
+      for (size_t k = 2; k < cs.size(); ++k)
+        std::atomic_ref<char>(d.non_manifold_faces[cs[k] / 3])
+            .store(true, std::memory_order_relaxed);
+    }
+  });
+
+  for (auto& c : counts) {
+    d.num_non_manifold_edges += c.num_non_manifold_edges;
+    d.is_oriented = d.is_oriented && c.is_oriented;
+    c = {};
+  }
+
+  // What is left after cleanup.
+  for_each_run([&](auto t, auto begin, auto end) {
+    size_t num_forward = 0, num_backward = 0;
+    for (auto i = begin; i < end; ++i) {
+      auto f = hs[i].c / 3;
+      if (is_duplicate(begin, first_of_face(begin, i)) ||
+          d.non_manifold_faces[f])
+        continue;
+      (is_forward(hs[i]) ? num_forward : num_backward) += 1;
+    }
+    if (num_forward > 1 || num_backward > 1) counts[t].is_oriented = false;
+    if (num_forward + num_backward == 1) ++counts[t].num_boundary_edges;
+    if (num_forward + num_backward > 2)
+      ++counts[t].num_remaining_non_manifold_edges;
+  });
+
+  for (const auto& c : counts) {
+    d.num_boundary_edges += c.num_boundary_edges;
+    d.is_oriented_after_cleanup = d.is_oriented_after_cleanup && c.is_oriented;
+    d.is_edge_manifold_after_cleanup = d.is_edge_manifold_after_cleanup &&
+                                       c.num_remaining_non_manifold_edges == 0;
+  }
+
+  d.num_duplicate_faces =
+      std::count(d.duplicate_faces.begin(), d.duplicate_faces.end(), true);
+  d.num_non_manifold_faces = std::count(d.non_manifold_faces.begin(),
+                                        d.non_manifold_faces.end(), true);
+  return d;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// Lock-free disjoint set forest over the indices of parent, which starts with
+// every index being its own root. Roots are always the smallest index of their
+// set. The root of x is found halving the path on the way, a failed compare
+// exchange only means that another thread already did it.
+template <typename Index>
+Index disjoint_set_find(std::vector<Index>& parent, Index x) {
+  while (true) {
+    auto p = std::atomic_ref<Index>(parent[x]).load(std::memory_order_relaxed);
+    if (p == x) return x;
+    auto g = std::atomic_ref<Index>(parent[p]).load(std::memory_order_relaxed);
+    if (p != g)
+      std::atomic_ref<Index>(parent[x]).compare_exchange_weak(
+          p, g, std::memory_order_relaxed);
+    x = g;
+  }
+}
+
+// Merge the sets of x and y linking the larger root below the smaller one,
+// retried if another thread linked the root in the meantime.
+template <typename Index>
+void disjoint_set_unite(std::vector<Index>& parent, Index x, Index y) {
+  while (true) {
+    x = disjoint_set_find(parent, x);
+    y = disjoint_set_find(parent, y);
+    if (x == y) return;
+    if (x < y) std::swap(x, y);
+    auto expected = x;
+    if (std::atomic_ref<Index>(parent[x]).compare_exchange_strong(
+            expected, y, std::memory_order_relaxed))
+      return;
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <robin_hood.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Key of the ordered pair of vertices (v0, v1) for hash tables and sorting,
+// indices up to 32 bits are packed in a single integer.
+template <typename Index>
+auto edge_key(Index v0, Index v1) {
+  if constexpr (sizeof(Index) <= 4)
+    return static_cast<uint64_t>(v0) << 32 | static_cast<uint64_t>(v1);
+  else
+    return std::pair<uint64_t, uint64_t>(v0, v1);
+}
+
+struct EdgeKeyHash {
+  size_t operator()(uint64_t k) const {
+    return robin_hood::hash<uint64_t>{}(k);
+  }
+  size_t operator()(const std::pair<uint64_t, uint64_t>& k) const {
+    return robin_hood::hash_bytes(&k, sizeof(k));
+  }
+};
+
+template <typename Index>
+using EdgeKey = decltype(edge_key(Index{}, Index{}));
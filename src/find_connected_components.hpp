@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "Mesh.hpp"
+#include "disjoint_set.hpp"
+#include "parallel_task.hpp"
+
+// Label the faces by connected component (faces sharing a vertex are
+// connected) with a lock-free union-find over the vertices of f2v, no face
+// adjacency is needed. Components are numbered in order of their first face,
+// as a depth first search over the faces would do. Returns the number of
+// components.
+template <typename Scalar, typename Index>
+Index find_connected_components(const BasicMesh<Scalar, Index>& m,
+                                std::vector<Index>& f2cc) {
+  auto num_vertices = static_cast<Index>(m.num_vertices());
+  auto num_faces = static_cast<Index>(m.num_faces());
+
+  std::vector<Index> parent(num_vertices);
+  std::iota(parent.begin(), parent.end(), Index{0});
+  {
+    const auto task = [&](auto, auto f, auto end) {
+      for (; f < end; ++f) {
+        disjoint_set_unite(parent, m.f2v[f * 3], m.f2v[f * 3 + 1]);
+        disjoint_set_unite(parent, m.f2v[f * 3], m.f2v[f * 3 + 2]);
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_faces, task);
+  }
+
+  // Root of every face and first face of every root.
+  f2cc.resize(num_faces);
+  std::vector<Index> first(num_vertices, std::numeric_limits<Index>::max());
+  {
+    const auto task = [&](auto, auto f, auto end) {
+      for (; f < end; ++f) {
+        auto r = disjoint_set_find(parent, m.f2v[f * 3]);
+        f2cc[f] = r;
+        std::atomic_ref<Index> a(first[r]);
+        auto x = a.load(std::memory_order_relaxed);
+        while (f < x &&
+               !a.compare_exchange_weak(x, f, std::memory_order_relaxed)) {
+        }
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_faces, task);
+  }
+
+  // Number the first faces in order, per thread block then within the blocks
+  // (the parallel_task split is the same for all passes). Roots are labeled in
+  // parent as it is not needed anymore.
+  std::vector<Index> counts(utl::NUM_HARDWARE_THREADS, 0);
+  {
+    const auto task = [&](auto i, auto f, auto end) {
+      Index count = 0;
+      for (; f < end; ++f) count += first[f2cc[f]] == f;
+      counts[i] = count;
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_faces, task);
+  }
+
+  std::vector<Index> offsets(counts.size(), 0);
+  std::partial_sum(counts.begin(), counts.end() - 1, offsets.begin() + 1);
+  {
+    const auto task = [&](auto i, auto f, auto end) {
+      auto label = offsets[i];
+      for (; f < end; ++f)
+        if (first[f2cc[f]] == f) parent[f2cc[f]] = label++;
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_faces, task);
+  }
+  {
+    const auto task = [&](auto, auto f, auto end) {
+      for (; f < end; ++f) f2cc[f] = parent[f2cc[f]];
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_faces, task);
+  }
+
+  return std::reduce(counts.begin(), counts.end());
+}
@@ -8,9 +8,10 @@
 
 #include "Mesh.hpp"
 
-template <typename Bool>
-void find_duplicate_faces(const Mesh& m, std::vector<Bool>& fflags) {
-  constexpr auto equal = [](const int* p, const int* q) {
+template <typename Scalar, typename Index, typename Bool>
+void find_duplicate_faces(const BasicMesh<Scalar, Index>& m,
+                          std::vector<Bool>& fflags) {
+  constexpr auto equal = [](const Index* p, const Index* q) {
     auto pmax = std::max({p[0], p[1], p[2]});
     auto pmin = std::min({p[0], p[1], p[2]});
     auto pmid =
@@ -26,13 +27,13 @@ void find_duplicate_faces(const Mesh& m, std::vector<Bool>& fflags) {
 
   // WARNING: Bad but commutative hash function.
   constexpr auto hash = [](const auto* p) {
-    return std::hash<int>{}(p[0] ^ p[1] ^ p[2]);
+    return std::hash<Index>{}(p[0] ^ p[1] ^ p[2]);
   };
 
-  robin_hood::unordered_set<const int*, decltype(hash), decltype(equal)> set(
+  robin_hood::unordered_set<const Index*, decltype(hash), decltype(equal)> set(
       10, hash, equal);
 
-  for (auto f = 0; f < m.num_faces(); ++f) {
+  for (size_t f = 0; f < m.num_faces(); ++f) {
     auto [it, inserted] = set.insert(&m.f2v[f * 3]);
     if (!inserted) fflags[f] = true;
   }
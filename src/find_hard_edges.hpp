@@ -15,11 +15,13 @@
 //   \  /
 //    f1
 // clang-format on
-template <bool BY_COORDINATES = false, typename Bool>
-void find_hard_edges(const Mesh& m, std::vector<Bool>& eflags) {
+template <bool BY_COORDINATES = false, typename Scalar, typename Index,
+          typename Bool>
+void find_hard_edges(const BasicMesh<Scalar, Index>& m,
+                     std::vector<Bool>& eflags) {
   assert(eflags.size() == m.num_edges());
 
-  for (auto e = 0; e < m.num_edges(); ++e) {
+  for (size_t e = 0; e < m.num_edges(); ++e) {
     auto v0 = m.e2v[e * 2];
     auto v1 = m.e2v[e * 2 + 1];
     auto f0 = m.e2f[e * 2];
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <robin_hood.h>
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "Submesh.hpp"
+#include "parallel_task.hpp"
+#include "to_vector3d.hpp"
+
+// Component j is a copy of component prototype moved by the rigid motion
+// x_j = rotation * x_prototype + translation (vertex by vertex in their local
+// numbering). Unique components are their own prototype with the identity.
+template <typename Index>
+struct Instance {
+  Index prototype;
+  Eigen::Matrix3d rotation;
+  Eigen::Vector3d translation;
+};
+
+// Group the components that are copies of each other up to a rotation and a
+// translation. Components are hashed on the exact invariants, their number of
+// vertices and their faces in local numbering, and components with the same
+// hash are checked vertex by vertex, first for a pure translation (principal
+// axes are unstable for symmetric shapes) and then in their frames, with
+// distances up to tolerance times the RMS radius. The frame of a component is
+// its centroid and the principal axes of its vertices (signs fixed by the third
+// moments, right handed), which is the same for copies. Copies must list their
+// faces in the same order, as exports of repeated parts do. The local
+// numbering is built in scratch buffers, the views keep nothing. Returns the
+// instances and counts the prototypes in num_prototypes.
+template <typename Scalar, typename Index>
+auto find_instances(const std::vector<BasicSubmesh<Scalar, Index>>& views,
+                    double tolerance, size_t& num_prototypes) {
+  struct Frame {
+    Eigen::Vector3d centroid;
+    // Rows are the principal axes.
+    Eigen::Matrix3d axes;
+    double radius;
+    uint64_t hash;
+  };
+
+  // Local numbering of a component.
+  struct Local {
+    std::vector<Index> vertices;
+    std::vector<Index> f2v;
+  };
+
+  auto num_components = views.size();
+  std::vector<Frame> frames(num_components);
+
+  const auto position = [&](size_t i, const Local& l,
+                            size_t k) -> Eigen::Vector3d {
+    return to_vector3d(&views[i].parent().v[l.vertices[k] * 3]);
+  };
+
+  {
+    const auto task = [&](auto, auto i, auto end) {
+      Local l;
+      for (; i < end; ++i) {
+        views[i].number_vertices(l.vertices, l.f2v);
+        auto& frame = frames[i];
+        auto n = l.vertices.size();
+
+        Eigen::Vector3d c = Eigen::Vector3d::Zero();
+        for (size_t k = 0; k < n; ++k) c += position(i, l, k);
+        c /= n;
+
+        Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+        for (size_t k = 0; k < n; ++k) {
+          Eigen::Vector3d d = position(i, l, k) - c;
+          cov += d * d.transpose();
+        }
+        cov /= n;
+
+        // Increasing eigenvalues, axes taken in decreasing order.
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(cov);
+        Eigen::Vector3d e0 = solver.eigenvectors().col(2);
+        Eigen::Vector3d e1 = solver.eigenvectors().col(1);
+        double s0 = 0.0, s1 = 0.0;
+        for (size_t k = 0; k < n; ++k) {
+          Eigen::Vector3d d = position(i, l, k) - c;
+          s0 += std::pow(e0.dot(d), 3);
+          s1 += std::pow(e1.dot(d), 3);
+        }
+        if (s0 < 0.0) e0 = -e0;
+        if (s1 < 0.0) e1 = -e1;
+
+        frame.centroid = c;
+        frame.axes.row(0) = e0;
+        frame.axes.row(1) = e1;
+        frame.axes.row(2) = e0.cross(e1);
+        frame.radius = std::sqrt(cov.trace());
+
+        uint64_t hash = robin_hood::hash_bytes(l.f2v.data(),
+                                               l.f2v.size() * sizeof(Index));
+        hash ^= robin_hood::hash<uint64_t>{}(n) + 0x9e3779b97f4a7c15 +
+                (hash << 6) + (hash >> 2);
+        frame.hash = hash;
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, num_components,
+                       task);
+  }
+
+  // The motion taking component p onto component j, if any.
+  const auto match = [&](size_t p, const Local& lp, size_t j, const Local& lj,
+                         Instance<Index>& instance) {
+    if (lp.vertices.size() != lj.vertices.size() || lp.f2v != lj.f2v)
+      return false;
+
+    const auto& fp = frames[p];
+    const auto& fj = frames[j];
+    auto tol = tolerance * std::max(fp.radius, fj.radius);
+
+    const auto check = [&](const Eigen::Matrix3d& r) {
+      for (size_t k = 0; k < lp.vertices.size(); ++k) {
+        Eigen::Vector3d x =
+            r * (position(p, lp, k) - fp.centroid) + fj.centroid;
+        if ((x - position(j, lj, k)).norm() > tol) return false;
+      }
+      instance = {static_cast<Index>(p), r, fj.centroid - r * fp.centroid};
+      return true;
+    };
+
+    return check(Eigen::Matrix3d::Identity()) ||
+           check(fj.axes.transpose() * fp.axes);
+  };
+
+  std::vector<Instance<Index>> instances(num_components);
+
+  // Components sorted by hash, every run with the same hash is matched
+  // against the prototypes found so far in the run by one thread. Only the
+  // numbering of these prototypes is kept, until the end of the run.
+  std::vector<size_t> order(num_components);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::sort(order.begin(), order.end(), [&](auto l, auto r) {
+    return std::pair(frames[l].hash, l) < std::pair(frames[r].hash, r);
+  });
+
+  std::vector<size_t> runs;
+  for (size_t i = 0; i < num_components; ++i)
+    if (i == 0 || frames[order[i]].hash != frames[order[i - 1]].hash)
+      runs.push_back(i);
+  runs.push_back(num_components);
+
+  std::atomic<size_t> next = 0;
+  std::atomic<size_t> count = 0;
+  const auto task = [&](auto, auto, auto) {
+    std::vector<std::pair<size_t, Local>> prototypes;
+    Local lj;
+    for (auto r = next++; r + 1 < runs.size(); r = next++) {
+      prototypes.clear();
+      for (auto i = runs[r]; i < runs[r + 1]; ++i) {
+        auto j = order[i];
+        views[j].number_vertices(lj.vertices, lj.f2v);
+        auto found = std::any_of(
+            prototypes.begin(), prototypes.end(), [&](const auto& p) {
+              return match(p.first, p.second, j, lj, instances[j]);
+            });
+        if (!found) {
+          instances[j] = {static_cast<Index>(j), Eigen::Matrix3d::Identity(),
+                          Eigen::Vector3d::Zero()};
+          prototypes.emplace_back(j, lj);
+          ++count;
+        }
+      }
+    }
+  };
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0u, utl::NUM_HARDWARE_THREADS,
+                     task);
+
+  num_prototypes = count;
+  return instances;
+}
@@ -6,9 +6,10 @@
 
 #include "Mesh.hpp"
 #include "parallel_task.hpp"
+#include "to_vector3d.hpp"
 
-template <typename Bool>
-void find_sharp_edges(const Mesh& m, double min, double max,
+template <typename Scalar, typename Index, typename Bool>
+void find_sharp_edges(const BasicMesh<Scalar, Index>& m, double min, double max,
                       std::vector<Bool>& eflags) {
   assert(eflags.size() == m.num_edges());
 
@@ -22,8 +23,8 @@ void find_sharp_edges(const Mesh& m, double min, double max,
         continue;
       }
 
-      Eigen::Vector3d n0{&m.fn[f0 * 3]};
-      Eigen::Vector3d n1{&m.fn[f1 * 3]};
+      Eigen::Vector3d n0 = to_vector3d(&m.fn[f0 * 3]);
+      Eigen::Vector3d n1 = to_vector3d(&m.fn[f1 * 3]);
 
       // Assume normals are normalized.
       auto cos = n0.dot(n1);
@@ -31,5 +32,6 @@ void find_sharp_edges(const Mesh& m, double min, double max,
     }
   };
 
-  utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_edges(), task);
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_edges()), task);
 }
\ No newline at end of file
@@ -1,24 +1,102 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <limits>
 
 #include "Quadric.hpp"
 
+// Number of quadrics solved together by get_optimal_positions.
+inline constexpr int OPTIMAL_POSITION_BATCH = 64;
+
+// Solve A * x = -b in closed form with the adjugate of the symmetric matrix A
+// given by its upper triangle. Returns false, without branching so that loops
+// over batches vectorize, if A is close to singular or the solution inaccurate.
+inline bool solve_quadric(double a00, double a01, double a02, double a11,
+                          double a12, double a22, double b0, double b1,
+                          double b2, double& x0, double& x1, double& x2) {
+  // Cofactors, the adjugate is symmetric too.
+  auto c00 = a11 * a22 - a12 * a12;
+  auto c01 = a02 * a12 - a01 * a22;
+  auto c02 = a01 * a12 - a02 * a11;
+  auto c11 = a00 * a22 - a02 * a02;
+  auto c12 = a01 * a02 - a00 * a12;
+  auto c22 = a00 * a11 - a01 * a01;
+
+  auto det = a00 * c00 + a01 * c01 + a02 * c02;
+  auto is_regular = det >= std::numeric_limits<float>::epsilon();
+  auto inv = 1.0 / det;
+
+  x0 = -(c00 * b0 + c01 * b1 + c02 * b2) * inv;
+  x1 = -(c01 * b0 + c11 * b1 + c12 * b2) * inv;
+  x2 = -(c02 * b0 + c12 * b1 + c22 * b2) * inv;
+
+  // Relative residual, squared to avoid the square roots.
+  auto r0 = a00 * x0 + a01 * x1 + a02 * x2 + b0;
+  auto r1 = a01 * x0 + a11 * x1 + a12 * x2 + b1;
+  auto r2 = a02 * x0 + a12 * x1 + a22 * x2 + b2;
+  constexpr double eps = std::numeric_limits<float>::epsilon();
+  auto is_accurate =
+      r0 * r0 + r1 * r1 + r2 * r2 <= eps * eps * (b0 * b0 + b1 * b1 + b2 * b2);
+
+  return is_regular & is_accurate;
+}
+
 static bool get_optimal_position(const Quadric& q, Eigen::Vector3d& x) {
-  // if (q.A.determinant() == 0) return false;
-  if (q.A.determinant() < std::numeric_limits<float>::epsilon()) return false;
+  const auto& p = q.q;
+  return solve_quadric(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8],
+                       x[0], x[1], x[2]);
+}
 
-  x = -q.A.ldlt().solve(q.b);
-  assert(q.b != Eigen::Vector3d::Zero());
+// Solve n <= OPTIMAL_POSITION_BATCH quadrics at once. They are transposed to
+// one array per coefficient and solved by a loop over these arrays, which the
+// compiler turns into SIMD code (as wide as the target allows, e.g. four lanes
+// with AVX2). is_solved[i] is set as the result of get_optimal_position for
+// qs[i].
+static void get_optimal_positions(const Quadric* qs, int n, Eigen::Vector3d* xs,
+                                  char* is_solved) {
+  assert(n <= OPTIMAL_POSITION_BATCH);
 
-  if ((q.A * x + q.b).norm() / q.b.norm() >
-      std::numeric_limits<float>::epsilon()) {
-    std::cerr << "WARNING: High relative error.\n";
-    return false;
+  // Lanes past n solve zero quadrics, so that the loop has a fixed count.
+  alignas(64) double q[9][OPTIMAL_POSITION_BATCH] = {};
+  alignas(64) double x[3][OPTIMAL_POSITION_BATCH];
+  alignas(64) double s[OPTIMAL_POSITION_BATCH];
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < 9; ++j) q[j][i] = qs[i].q[j];
+
+  for (int i = 0; i < OPTIMAL_POSITION_BATCH; ++i)
+    s[i] = solve_quadric(q[0][i], q[1][i], q[2][i], q[3][i], q[4][i], q[5][i],
+                         q[6][i], q[7][i], q[8][i], x[0][i], x[1][i], x[2][i])
+               ? 1.0
+               : 0.0;
+
+  for (int i = 0; i < n; ++i) {
+    xs[i] = {x[0][i], x[1][i], x[2][i]};
+    is_solved[i] = s[i] != 0.0;
   }
+}
+
+// Point minimizing the quadric on the segment [x0, x1], the fallback when the
+// quadric has no unique minimizer (e.g. planar or linear neighborhoods).
+template <typename DerivedX>
+Eigen::Vector3d get_edge_position(const Quadric& q,
+                                  const Eigen::MatrixBase<DerivedX>& x0,
+                                  const Eigen::MatrixBase<DerivedX>& x1) {
+  auto A = q.A();
+  Eigen::Vector3d d = x1 - x0;
+
+  // q(x0 + t * d) = a * t^2 + 2 * g * t + q(x0).
+  auto a = d.dot(A * d);
+  auto g = d.dot(A * x0 + q.b());
+
+  if (a > std::numeric_limits<double>::epsilon() * d.squaredNorm())
+    return x0 + std::clamp(-g / a, 0.0, 1.0) * d;
 
-  return true;
-}
\ No newline at end of file
+  // Cost constant or linear along the edge.
+  Eigen::Vector3d xm = (x0 + x1) * 0.5;
+  auto c0 = q(x0), c1 = q(x1), cm = q(xm);
+  if (cm <= std::min(c0, c1)) return xm;
+  return c0 <= c1 ? x0 : x1;
+}
@@ -5,10 +5,11 @@
 
 #include "Mesh.hpp"
 
-static bool is_closed(const Mesh& m) {
+template <typename Scalar, typename Index>
+bool is_closed(const BasicMesh<Scalar, Index>& m) {
   assert(m.num_edges() > 0);
   assert(!m.e2f.empty());
-  for (auto e = 0; e < m.num_edges(); ++e)
+  for (size_t e = 0; e < m.num_edges(); ++e)
     if (m.e2f[2 * e + 1] == -1) return false;
   return true;
 }
\ No newline at end of file
@@ -1,133 +1,224 @@
 #include <iostream>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #define _USE_MATH_DEFINES
 #include <cmath>
-// clang-format off
-// This has to be before any boost/graph stuff.
-#include <boost/graph/vector_as_graph.hpp>
-#include <boost/graph/connected_components.hpp>
 #include <boost/timer/timer.hpp>
-// clang-format on
 
 #include "Mesh.hpp"
 #include "Quadric.hpp"
+#include "Submesh.hpp"
 #include "WriterVTK.hpp"
 #include "collapse_edge.hpp"
 #include "compress_buffer.hpp"
+#include "decimate.hpp"
+#include "decimate_components.hpp"
+#include "decimate_corner_table.hpp"
+#include "decimate_out_of_core.hpp"
+#include "diagnose_faces.hpp"
 #include "find_boundary_edges.hpp"
-#include "find_buffer_duplicates.hpp"
-#include "find_duplicate_faces.hpp"
+#include "find_connected_components.hpp"
+#include "find_instances.hpp"
 #include "find_hard_edges.hpp"
-#include "find_non_manifold_faces.hpp"
 #include "find_sharp_edges.hpp"
 #include "get_optimal_position.hpp"
 #include "is_closed.hpp"
 #include "is_edge_manifold.hpp"
-#include "is_oriented.hpp"
 #include "make_compressed.hpp"
 #include "make_edge_heap.hpp"
 #include "make_edges.hpp"
 #include "make_face_normals_and_areas.hpp"
+#include "make_inverse_adjacency.hpp"
 #include "make_smooth_normals.hpp"
 #include "make_topology.hpp"
 #include "make_vertex_quadric.hpp"
 #include "make_vertex_quadrics.hpp"
+#include "readCache.hpp"
 #include "readOBJ.hpp"
-#include "split_into_connected_components.hpp"
+#include "readPLY.hpp"
+#include "readSTL.hpp"
 #include "test_collapse_boundaries.hpp"
 #include "test_collapse_normal_flipping.hpp"
 #include "test_collapse_shared_neighbors.hpp"
+#include "weld_buffer.hpp"
+#include "writeCache.hpp"
 #include "writeOBJ.hpp"
+#include "writePLY.hpp"
 #include "writeVTK_edge_patch.hpp"
 #include "writeVTK_vertex_patch.hpp"
 
-int main(int argc, char** argv) {
-  boost::timer::auto_cpu_timer t;
-
-  Mesh m;
+// Usage: qslim input component target [--output path] [--vtk path]
+// [--cache path] [--out-of-core MB] [--corner-table] [--bucket-queue]
+// [--instances] [--instance-tolerance t] [--weld epsilon] [--float | --int64]
+// The component is either an index or "all" to decimate every component
+// concurrently, each one getting a share of the target proportional to its
+// number of faces, and merge them in the output. With --instances components
+// that are rigidly moved copies of another one are decimated only once, their
+// vertices may be off by --instance-tolerance times the size of the component
+// (1e-6 by default).
+// The input is either an OBJ file, a binary PLY or STL file or a mesh cache
+// (.qmc) written by a previous run with --cache, which stores the picked
+// component after preprocessing together with its connectivity, so that both
+// parsing and topology construction are skipped. With --out-of-core an OBJ
+// input is decimated as a whole (all components) within the given memory
+// budget. With --corner-table the per-vertex and edge relations are not built
+// (those of a cache are released) and the collapse runs on a corner table made
+// from the faces. With --bucket-queue collapses are picked from cost bins
+// instead of in exact order, which is faster on big meshes for a slightly
+// worse result. With --float positions, normals and areas are
+// stored in single precision, with --int64 indices are 64-bit. Caches and the
+// out-of-core mode are only available with the default types. Vertices closer
+// than the --weld distance are merged (only identical ones by default), faces
+// left with a repeated vertex are removed, then duplicate and non-manifold
+// faces. Normals and texture coordinates are merged when identical. The output
+// is written as OBJ or, if the --output path ends with .ply, as binary PLY (not
+// with --int64), next to a VTK file given by --vtk, a legacy binary .vtk or
+// an XML .vtu if the path ends with .vtu. They are out.obj and out.vtk by
+// default.
+template <typename Scalar, typename Index>
+int run(int argc, char** argv) {
+  using MeshT = BasicMesh<Scalar, Index>;
+  constexpr auto IS_DEFAULT = std::is_same_v<MeshT, Mesh>;
+
+  std::string_view input = argv[1];
+  const char* cache_path = nullptr;
+  std::string_view output = "out.obj";
+  std::string_view vtk_output = "out.vtk";
+  size_t memory_budget = 0;
+  auto use_corner_table = false;
+  auto use_bucket_queue = false;
+  auto use_instances = false;
+  auto instance_tolerance = 1.0e-6;
+  auto weld_epsilon = 0.0;
+  for (auto i = 4; i < argc; ++i) {
+    if (std::string_view{argv[i]} == "--corner-table") use_corner_table = true;
+    if (std::string_view{argv[i]} == "--bucket-queue") use_bucket_queue = true;
+    if (std::string_view{argv[i]} == "--instances") use_instances = true;
+    if (i + 1 == argc) break;
+    if (std::string_view{argv[i]} == "--cache") cache_path = argv[++i];
+    if (std::string_view{argv[i]} == "--output") output = argv[++i];
+    if (std::string_view{argv[i]} == "--vtk") vtk_output = argv[++i];
+    if (std::string_view{argv[i]} == "--instance-tolerance")
+      instance_tolerance = std::stod(argv[++i]);
+    if (std::string_view{argv[i]} == "--weld")
+      weld_epsilon = std::stod(argv[++i]);
+    if (std::string_view{argv[i]} == "--out-of-core")
+      memory_budget = std::stoull(argv[++i]) << 20;
+  }
 
-  // Read original mesh.
-  readOBJ(argv[1], m);
+  const auto write_output = [output, vtk_output](MeshT& m) {
+    std::cout << "Finished.\n";
+    make_compressed(m);
+    // make_topology(m);
+    // make_edges(m);
+    // make_face_normals_and_areas(m);
+    // make_smooth_normals(m);
+
+    if constexpr (sizeof(Index) == 4) {
+      if (output.ends_with(".ply")) {
+        std::cout << "Writing PLY.\n";
+        writePLY(output, m);
+      }
+    }
+    if (!output.ends_with(".ply")) {
+      std::cout << "Writing OBJ.\n";
+      writeOBJ(output, m);
+    }
 
-  // Pick a mesh.
-  {
-    // Big problems.
     {
-      std::vector<char> duplicate_faces(m.num_faces(), false);
-      find_duplicate_faces(m, duplicate_faces);
-      std::cout << "Duplicate faces: "
-                << std::count(duplicate_faces.begin(), duplicate_faces.end(),
-                              true)
-                << '\n';
-
-      // Brutally remove duplicate faces.
-      m.f2v.resize(3 * compress_buffer<3>(m.f2v.data(), m.num_faces(),
-                                          duplicate_faces.data()));
-      if (!m.t.empty())
-        m.f2t.resize(3 * compress_buffer<3>(m.f2t.data(), m.num_faces(),
-                                            duplicate_faces.data()));
-      if (!m.n.empty())
-        m.f2n.resize(3 * compress_buffer<3>(m.f2n.data(), m.num_faces(),
-                                            duplicate_faces.data()));
+      std::cout << "Writing VTK.\n";
+      WriterVTK w;
+      const auto write = [&w, vtk_output] {
+        if (vtk_output.ends_with(".vtu"))
+          w.write_xml(vtk_output);
+        else
+          w.write_binary(vtk_output);
+      };
+      if constexpr (IS_DEFAULT) {
+        w.add_point_buffer(m.v.data(), m.num_vertices(), 3);
+        w.add_cell_buffer(m.f2v.data(), m.num_faces(), WriterVTK::TRIANGLE);
+        write();
+      } else {
+        // The writer only takes double positions and int indices.
+        std::vector<double> v(m.v.begin(), m.v.end());
+        std::vector<int> f2v(m.f2v.begin(), m.f2v.end());
+        w.add_point_buffer(v.data(), m.num_vertices(), 3);
+        w.add_cell_buffer(f2v.data(), m.num_faces(), WriterVTK::TRIANGLE);
+        write();
+      }
     }
+  };
 
-    // Mesh regularity.
-    {
-      std::cout << "Oriented: " << is_oriented(m.f2v) << '\n';
-      std::vector<double> nmf(m.num_faces(), false);
-      find_non_manifold_faces(m.f2v, nmf);
-      std::cout << "Edge-manifold: "
-                << (std::count(nmf.begin(), nmf.end(), true) == 0) << '\n';
-      std::cout << "Non-manifold faces: "
-                << std::count(nmf.begin(), nmf.end(), true) << '\n';
-
-      // debug
-      // {
-      //   WriterVTK w;
-      //   w.add_point_buffer(m.v.data(), m.num_vertices(), 3);
-      //   w.add_cell_buffer(m.f2v.data(), m.num_faces(), WriterVTK::TRIANGLE);
-      //   w.add_scalar_buffer(nmf.data(), nmf.size(), WriterVTK::CELL);
-      //   w.write("out.vtk");
-      // }
-      // exit(1);
-
-      // Brutally remove non manifold faces.
-      m.f2v.resize(3 *
-                   compress_buffer<3>(m.f2v.data(), m.num_faces(), nmf.data()));
-      if (!m.t.empty())
-        m.f2t.resize(
-            3 * compress_buffer<3>(m.f2t.data(), m.num_faces(), nmf.data()));
-      if (!m.n.empty())
-        m.f2n.resize(
-            3 * compress_buffer<3>(m.f2n.data(), m.num_faces(), nmf.data()));
+  MeshT m;
 
-      // Check for consistency.
-      std::cout << "Oriented: " << is_oriented(m.f2v) << '\n';
-      nmf.assign(m.num_faces(), false);
-      find_non_manifold_faces(m.f2v, nmf);
-      std::cout << "Edge-manifold: "
-                << (std::count(nmf.begin(), nmf.end(), true) == 0) << '\n';
-    }
+  auto all_components = std::string_view{argv[2]} == "all";
+  if (all_components && (cache_path || input.ends_with(".qmc"))) {
+    std::fprintf(stderr, "ERROR: Caches hold a single component.\n");
+    return EXIT_FAILURE;
+  }
 
-    // Preprocess vertices.
-#if 1
-    {
-      constexpr auto hash = [](const double* x) {
-        const auto h0 = std::hash<double>{}(x[0]);
-        const auto h1 = std::hash<double>{}(x[1]);
-        const auto h2 = std::hash<double>{}(x[2]);
+  if (output.ends_with(".ply") && sizeof(Index) != 4) {
+    std::fprintf(stderr, "ERROR: PLY output needs 32-bit indices.\n");
+    return EXIT_FAILURE;
+  }
 
-        return (h0 ^ (h1 << 1)) ^ h2;
-      };
+  if ((memory_budget || cache_path || input.ends_with(".qmc")) && !IS_DEFAULT) {
+    std::fprintf(stderr,
+                 "ERROR: Caches and --out-of-core need the default types.\n");
+    return EXIT_FAILURE;
+  }
+
+  if (memory_budget && !input.ends_with(".obj")) {
+    std::fprintf(stderr, "ERROR: --out-of-core only reads OBJ files.\n");
+    return EXIT_FAILURE;
+  }
+
+  if constexpr (IS_DEFAULT)
+    if (memory_budget) {
+      auto target_num_faces = std::max(4, std::stoi(argv[3]));
+      if (!decimate_out_of_core(input, target_num_faces, memory_budget,
+                                use_bucket_queue, m)) {
+        std::fprintf(stderr, "ERROR: No faces read from \"%s\".\n",
+                     argv[1]);
+        return EXIT_FAILURE;
+      }
+      write_output(m);
+      return EXIT_SUCCESS;
+    }
+
+  if (input.ends_with(".qmc")) {
+    // Warm start.
+    if constexpr (IS_DEFAULT)
+      if (!readCache(input, m)) return EXIT_FAILURE;
+    if (m.e2v.empty() && !use_corner_table) {
+      make_topology(m, false);
+      make_edges(m);
+    }
+    m.vdel.assign(m.num_vertices(), false);
+    m.fdel.assign(m.num_faces(), false);
+    m.edel.assign(m.num_edges(), false);
+  } else {
+    // Read original mesh.
+    if (input.ends_with(".ply")) {
+      if (!readPLY(input, m)) return EXIT_FAILURE;
+    } else if (input.ends_with(".stl")) {
+      if (!readSTL(input, m)) return EXIT_FAILURE;
+    } else {
+      readOBJ(input, m);
+    }
 
+    // Preprocess vertices before the diagnostics, welding can create duplicate
+    // and non manifold faces.
+    {
       std::vector<char> vflags(m.num_vertices(), false);
-      std::vector<int> ind0(m.num_vertices(), -1);
-      std::vector<int> ind1(m.num_vertices(), -1);
+      std::vector<Index> ind0(m.num_vertices(), -1);
+      std::vector<Index> ind1(m.num_vertices(), -1);
 
-      find_buffer_duplicates<3>(hash, m.v.data(), m.num_vertices(),
-                                vflags.data(), ind0.data());
+      weld_buffer<3>(m.v.data(), m.num_vertices(), weld_epsilon, vflags.data(),
+                     ind0.data());
 
       std::cout << "Vertex duplicates: "
                 << std::count(vflags.begin(), vflags.end(), true) << '\n';
@@ -136,6 +227,74 @@ int main(int argc, char** argv) {
                                     ind1.data()) *
                  3);
       for (auto& v : m.f2v) v = ind1[ind0[v]];
+
+      // Faces whose vertices were merged.
+      std::vector<char> fflags(m.num_faces(), false);
+      for (size_t f = 0; f < m.num_faces(); ++f) {
+        const auto* v = &m.f2v[f * 3];
+        fflags[f] = v[0] == v[1] || v[1] == v[2] || v[2] == v[0];
+      }
+      auto num_collapsed = std::count(fflags.begin(), fflags.end(), true);
+      std::cout << "Collapsed faces: " << num_collapsed << '\n';
+      if (num_collapsed > 0) {
+        m.f2v.resize(3 * compress_buffer<3>(m.f2v.data(), fflags.size(),
+                                            fflags.data()));
+        if (!m.t.empty())
+          m.f2t.resize(3 * compress_buffer<3>(m.f2t.data(), fflags.size(),
+                                              fflags.data()));
+        if (!m.n.empty())
+          m.f2n.resize(3 * compress_buffer<3>(m.f2n.data(), fflags.size(),
+                                              fflags.data()));
+      }
+    }
+
+    // Mesh regularity, all from a single sort of the half edges.
+    {
+      auto d = diagnose_faces(m.f2v);
+      std::cout << "Duplicate faces: " << d.num_duplicate_faces << '\n';
+      std::cout << "Oriented: " << d.is_oriented << '\n';
+      std::cout << "Edge-manifold: " << (d.num_non_manifold_faces == 0)
+                << '\n';
+      std::cout << "Non-manifold faces: " << d.num_non_manifold_faces << '\n';
+
+      // Brutally remove duplicate and non manifold faces.
+      std::vector<char> fflags(m.num_faces());
+      for (size_t f = 0; f < m.num_faces(); ++f)
+        fflags[f] = d.duplicate_faces[f] || d.non_manifold_faces[f];
+      m.f2v.resize(3 * compress_buffer<3>(m.f2v.data(), fflags.size(),
+                                          fflags.data()));
+      if (!m.t.empty())
+        m.f2t.resize(3 * compress_buffer<3>(m.f2t.data(), fflags.size(),
+                                            fflags.data()));
+      if (!m.n.empty())
+        m.f2n.resize(3 * compress_buffer<3>(m.f2n.data(), fflags.size(),
+                                            fflags.data()));
+
+      // Check for consistency.
+      std::cout << "Oriented: " << d.is_oriented_after_cleanup << '\n';
+      std::cout << "Edge-manifold: " << d.is_edge_manifold_after_cleanup
+                << '\n';
+      std::cout << "Boundary edges: " << d.num_boundary_edges << '\n';
+      std::cout << "Closed: " << d.is_closed() << '\n';
+    }
+
+#if 1
+    // Preprocess texture coordinates.
+    if (!m.t.empty()) {
+      std::vector<char> tflags(m.num_texture(), false);
+      std::vector<Index> ind0(m.num_texture(), -1);
+      std::vector<Index> ind1(m.num_texture(), -1);
+
+      weld_buffer<2>(m.t.data(), m.num_texture(), 0.0, tflags.data(),
+                     ind0.data());
+
+      std::cout << "Texture duplicates: "
+                << std::count(tflags.begin(), tflags.end(), true) << '\n';
+
+      m.t.resize(compress_buffer<2>(m.t.data(), m.num_texture(), tflags.data(),
+                                    ind1.data()) *
+                 2);
+      for (auto& t : m.f2t) t = ind1[ind0[t]];
     }
 #endif
 
@@ -144,41 +303,69 @@ int main(int argc, char** argv) {
     std::cout << "Zero area faces: "
               << std::count(m.fa.begin(), m.fa.end(), 0.0) << '\n';
 
-    // Compute connectivities.
-    make_topology(m);
-    make_edges(m);
-    m.fdel.assign(m.num_faces(), false);
-    m.vdel.assign(m.num_vertices(), false);
-    m.edel.assign(m.num_edges(), false);
+    // Edges of the whole mesh, the rest of the connectivity is built per
+    // component. The corner table path needs none of it.
+    if (!use_corner_table)
+      std::cout << "Non-manifold edges: " << make_edges(m) << '\n';
 
     // Pick a connected component.
-    std::vector<int> f2cc(m.num_faces());
-    auto num_components = boost::connected_components(m.f2f, f2cc.data());
+    std::vector<Index> f2cc;
+    auto num_components = find_connected_components(m, f2cc);
     std::cout << "Connected components: " << num_components << '\n';
 
-    std::vector<Mesh> ms;
-    {
-      std::vector<std::vector<int>> cc2f(num_components);
-      for (auto f = 0; f < m.num_faces(); ++f) cc2f[f2cc[f]].push_back(f);
+    // Components are views on the mesh, only the picked one is copied.
+    BasicAdjacency<Index> cc2f;
+    make_inverse_adjacency<1>(f2cc, num_components, 0, cc2f);
+    std::vector<BasicSubmesh<Scalar, Index>> views;
+    views.reserve(num_components);
+    for (Index cc = 0; cc < num_components; ++cc)
+      views.emplace_back(m, std::as_const(cc2f)[cc]);
+
+    if (all_components) {
+      std::vector<Instance<Index>> instances;
+      if (use_instances) {
+        size_t num_prototypes = 0;
+        instances = find_instances(views, instance_tolerance,
+                                   num_prototypes);
+        std::cout << "Unique components: " << num_prototypes << '\n';
+      }
 
-      split_into_connected_components(m, cc2f, ms);
+      std::cout << "Starting.\n";
+      {
+        boost::timer::auto_cpu_timer t;
+        auto target_num_faces = std::max<Index>(4, std::stoll(argv[3]));
+        decimate_components(views, target_num_faces, use_corner_table,
+                            use_bucket_queue, m, instances);
+      }
+      write_output(m);
+      return EXIT_SUCCESS;
     }
 
     {
       auto cn = std::stoi(argv[2]);
       std::cout << "Component number: " << cn << '\n';
-      m = ms[cn];
-      make_topology(m);
-      make_edges(m);
+      m = views[cn].compacted();
+      // Face to face connectivity is only needed by the cache, the corner
+      // table is built from f2v alone.
+      if (!use_corner_table || cache_path) {
+        make_topology(m, cache_path != nullptr);
+        make_edges(m);
+      }
       m.vdel.assign(m.num_vertices(), false);
       m.fdel.assign(m.num_faces(), false);
       m.edel.assign(m.num_edges(), false);
     }
+
+    if constexpr (IS_DEFAULT)
+      if (cache_path) {
+        make_face_normals_and_areas(m);
+        writeCache(cache_path, m);
+      }
   }
 
   // debug
   {
-    for (auto e = 0; e < m.num_edges(); ++e)
+    for (size_t e = 0; e < m.num_edges(); ++e)
       if (m.e2f[e * 2] == -1) std::cout << "ERROR\n";
   }
 
@@ -188,45 +375,42 @@ int main(int argc, char** argv) {
   std::cout << "Normals: " << m.num_normals() << '\n';
   std::cout << "Texture: " << m.num_texture() << '\n';
 
-  std::vector<char> is_boundary_edge(m.num_edges(), false);
-  find_boundary_edges(m, is_boundary_edge);
-  std::cout << "Boundary edges: "
-            << std::count(is_boundary_edge.begin(), is_boundary_edge.end(),
-                          true)
-            << '\n';
-
-  std::vector<char> is_boundary_vertex(m.num_vertices(), false);
-  for (auto e = 0; e < m.num_edges(); ++e) {
-    if (is_boundary_edge[e]) {
-      is_boundary_vertex[m.e2v[e * 2]] = true;
-      is_boundary_vertex[m.e2v[e * 2 + 1]] = true;
+  // The corner table path finds the boundary on its own.
+  std::vector<char> is_boundary_edge;
+  std::vector<char> is_boundary_vertex;
+  if (!use_corner_table) {
+    is_boundary_edge.assign(m.num_edges(), false);
+    find_boundary_edges(m, is_boundary_edge);
+    std::cout << "Boundary edges: "
+              << std::count(is_boundary_edge.begin(), is_boundary_edge.end(),
+                            true)
+              << '\n';
+
+    is_boundary_vertex.assign(m.num_vertices(), false);
+    for (size_t e = 0; e < m.num_edges(); ++e) {
+      if (is_boundary_edge[e]) {
+        is_boundary_vertex[m.e2v[e * 2]] = true;
+        is_boundary_vertex[m.e2v[e * 2 + 1]] = true;
+      }
     }
-  }
 
-  std::cout << "Boundary vertices: "
-            << std::count(is_boundary_vertex.begin(), is_boundary_vertex.end(),
-                          true)
-            << '\n';
+    std::cout << "Boundary vertices: "
+              << std::count(is_boundary_vertex.begin(),
+                            is_boundary_vertex.end(), true)
+              << '\n';
 
-  std::cout << "Closed: " << is_closed(m) << '\n';
+    std::cout << "Closed: " << is_closed(m) << '\n';
+  }
 
 // Preprocess normals.
 #if 1
   if (!m.n.empty()) {
-    constexpr auto hash = [](const double* x) {
-      const auto h0 = std::hash<double>{}(x[0]);
-      const auto h1 = std::hash<double>{}(x[1]);
-      const auto h2 = std::hash<double>{}(x[2]);
-
-      return (h0 ^ (h1 << 1)) ^ h2;
-    };
-
     std::vector<char> nflags(m.n.size() / 3, false);
-    std::vector<int> ind0(m.n.size() / 3, -1);
-    std::vector<int> ind1(m.n.size() / 3, -1);
+    std::vector<Index> ind0(m.n.size() / 3, -1);
+    std::vector<Index> ind1(m.n.size() / 3, -1);
 
-    find_buffer_duplicates<3>(hash, m.n.data(), m.n.size() / 3, nflags.data(),
-                              ind0.data());
+    weld_buffer<3>(m.n.data(), m.n.size() / 3, 0.0, nflags.data(),
+                   ind0.data());
 
     std::cout << "Normal duplicates: "
               << std::count(nflags.begin(), nflags.end(), true) << '\n';
@@ -239,8 +423,8 @@ int main(int argc, char** argv) {
   }
 #endif
 
-  // Mesh data.
-  make_face_normals_and_areas(m);
+  // Mesh data (a warm start already has it).
+  if (m.fa.size() != m.num_faces()) make_face_normals_and_areas(m);
   std::cout << "Zero area faces: " << std::count(m.fa.begin(), m.fa.end(), 0.0)
             << '\n';
 
@@ -257,120 +441,46 @@ int main(int argc, char** argv) {
 #endif
 
   // Collapse.
-  auto vq = make_vertex_quadrics(m, is_boundary_edge, is_boundary_vertex);
-
-  using edge_info_t = std::tuple<double, int, int>;
-  std::vector<std::tuple<double, int, int>> eh;
-  std::vector<Eigen::Vector3d> xs;
-
-  make_edge_heap(m, vq, eh, xs);
-
-  constexpr auto cmp = [](const auto& l, const auto& r) {
-    return std::get<0>(l) > std::get<0>(r);
-  };
-
-  std::vector<int> times(m.num_edges(), 0);
-
   {
     std::cout << "Starting.\n";
     boost::timer::auto_cpu_timer t;
 
-    auto num_faces = m.num_faces();
-    auto target_num_faces = std::max(4, std::stoi(argv[3]));
-
-    for (auto i = 0; num_faces > target_num_faces && !eh.empty(); ++i) {
-      const auto& [c, e, t] = eh.front();
-      const auto* x = &(xs[e][0]);
-      auto v0 = m.e2v[e * 2];
-      auto v1 = m.e2v[e * 2 + 1];
-
-      std::vector<std::tuple<int, Eigen::Vector3d, double>> ns;
-
-      // Put less expensive test first.
-      if (m.edel[e] || t < times[e] ||
-          !test_collapse_boundaries(m, e, is_boundary_edge,
-                                    is_boundary_vertex) ||
-          !test_collapse_shared_neighbors(m, e, is_boundary_edge) ||
-          !test_collapse_normal_flipping(m, e, x, std::cos(M_PI / 3.0), ns)) {
-        // std::cerr << "WARNING: Collapse of edge " << e
-        //           << " rejected. Deleted: " << static_cast<bool>(m.edel[e])
-        //           << ". Time " << t << " vs " << times[e] << ".\n";
-        std::pop_heap(eh.begin(), eh.end(), cmp);
-        eh.pop_back();
-      } else {
-        // std::cout << "Edge: " << e << '\n';
-        // std::cout << "Cost: " << c << '\n';
-        // std::cout << "Position: " << xs[e].transpose() << '\n';
-
-        // debug
-        // writeVTK_edge_patch("edge_patch.vtk", m, e);
-        collapse_edge(m, e, x, is_boundary_edge, is_boundary_vertex);
-        // writeVTK_vertex_patch("vertex_patch.vtk", m, v0);
-
-        // Update number of faces.
-        num_faces -= is_boundary_edge[e] ? 1 : 2;
-
-        // Update precomputed normals and areas.
-        for (const auto& [f, n, a] : ns) {
-          std::copy(&n[0], &n[0] + 3, &m.fn[f * 3]);
-          m.fa[f] = a;
-        }
-
-        // Update quadric of surviving vertex by accumulating error.
-        vq[v0].A += vq[v1].A;
-        vq[v0].b += vq[v1].b;
-        vq[v0].c += vq[v1].c;
-
-        // Update queue and quadrics.
-        std::pop_heap(eh.begin(), eh.end(), cmp);
-        eh.pop_back();
-
-        for (auto e : m.v2e[v0]) {
-          if (m.edel[e]) continue;
-
-          auto v1 = m.e2v[e * 2] == v0 ? m.e2v[e * 2 + 1] : m.e2v[e * 2];
-          assert(!m.vdel[v1]);
-
-          // Sum quadrics.
-          Quadric q;
-          q.A = vq[v0].A + vq[v1].A;
-          q.b = vq[v0].b + vq[v1].b;
-          q.c = vq[v0].c + vq[v1].c;
-
-          // Compute position.
-          Eigen::Vector3d x;
-          if (!get_optimal_position(q, x)) {
-            std::cout << "WARNING: Optimal position failed.\n";
-            Eigen::Vector3d x0{&m.v[v0 * 3]};
-            Eigen::Vector3d x1{&m.v[v1 * 3]};
-            x = (x0 + x1) * 0.5;
-          }
-
-          xs[e] = x;
-          ++times[e];
-          eh.emplace_back(vq[v0](x), e, times[e]);
-          std::push_heap(eh.begin(), eh.end(), cmp);
-        }
-      }
+    auto target_num_faces = std::max<Index>(4, std::stoll(argv[3]));
+    if (use_corner_table) {
+      m.v2f = {};
+      m.v2v = {};
+      m.f2f = {};
+      m.v2e = {};
+      m.e2v = {};
+      m.e2f = {};
+      if (use_bucket_queue)
+        decimate_corner_table<Scalar, Index, BucketQueue<Index>>(
+            m, target_num_faces);
+      else
+        decimate_corner_table(m, target_num_faces);
+    } else if (use_bucket_queue) {
+      decimate<Scalar, Index, BucketQueue<Index>>(
+          m, target_num_faces, is_boundary_edge, is_boundary_vertex);
+    } else {
+      decimate(m, target_num_faces, is_boundary_edge, is_boundary_vertex);
     }
   }
 
   // Output.
-  std::cout << "Finished.\n";
-  make_compressed(m);
-  // make_topology(m);
-  // make_edges(m);
-  // make_face_normals_and_areas(m);
-  // make_smooth_normals(m);
+  write_output(m);
 
-  std::cout << "Writing OBJ.\n";
-  writeOBJ("out.obj", m);
+  return EXIT_SUCCESS;
+}
 
-  {
-    std::cout << "Writing VTK.\n";
-    WriterVTK w;
-    w.add_point_buffer(m.v.data(), m.num_vertices(), 3);
-    w.add_cell_buffer(m.f2v.data(), m.num_faces(), WriterVTK::TRIANGLE);
-    w.write("out.vtk");
+int main(int argc, char** argv) {
+  boost::timer::auto_cpu_timer t;
+
+  for (auto i = 4; i < argc; ++i) {
+    if (std::string_view{argv[i]} == "--float")
+      return run<float, int32_t>(argc, argv);
+    if (std::string_view{argv[i]} == "--int64")
+      return run<double, int64_t>(argc, argv);
   }
-}
\ No newline at end of file
+
+  return run<double, int>(argc, argv);
+}
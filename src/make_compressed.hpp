@@ -6,10 +6,18 @@
 #include "Mesh.hpp"
 #include "compress_buffer.hpp"
 
-static void make_compressed(Mesh& m) {
+// Optionally return the map from old to new vertex indices (-1 for removed
+// vertices).
+template <typename Scalar, typename Index>
+void make_compressed(BasicMesh<Scalar, Index>& m,
+                     std::vector<Index>* vmap = nullptr) {
   // Compress generic data before removing faces.
   compress_buffer<3>(&m.fn[0], m.num_faces(), &m.fdel[0]);
   compress_buffer<1>(&m.fa[0], m.num_faces(), &m.fdel[0]);
+  if (m.f2t.size() == m.f2v.size())
+    m.f2t.resize(3 * compress_buffer<3>(&m.f2t[0], m.num_faces(), &m.fdel[0]));
+  if (m.f2n.size() == m.f2v.size())
+    m.f2n.resize(3 * compress_buffer<3>(&m.f2n[0], m.num_faces(), &m.fdel[0]));
 
   // Remove all the faces.
   auto num_faces = compress_buffer<3>(&m.f2v[0], m.num_faces(), &m.fdel[0]);
@@ -20,10 +28,12 @@ static void make_compressed(Mesh& m) {
   for (auto v : m.f2v)
     if (vdel[v]) vdel[v] = false;
 
-  std::vector<int> indmap(m.num_vertices(), -1);
+  std::vector<Index> indmap(m.num_vertices(), -1);
   m.v.resize(
       compress_buffer<3>(&m.v[0], m.num_vertices(), &vdel[0], &indmap[0]) * 3);
 
   // Reindex faces if some vertices are removed.
   for (auto& v : m.f2v) v = indmap[v];
+
+  if (vmap) vmap->swap(indmap);
 }
\ No newline at end of file
@@ -9,44 +9,50 @@
 #include "WriterVTK.hpp"
 #include "get_optimal_position.hpp"
 #include "parallel_task.hpp"
-
-static void make_edge_heap(const Mesh& m, const std::vector<Quadric>& vq,
-                           std::vector<std::tuple<double, int, int>>& eh,
-                           std::vector<Eigen::Vector3d>& xs) {
-  eh.resize(m.num_edges());
+#include "to_vector3d.hpp"
+
+// Fill the queue (IndexedHeap or BucketQueue) with the cost of collapsing
+// every edge and xs with the corresponding positions.
+template <typename Scalar, typename Index, typename Queue>
+void make_edge_heap(const BasicMesh<Scalar, Index>& m,
+                    const std::vector<Quadric>& vq, Queue& eh,
+                    std::vector<Eigen::Vector3d>& xs) {
+  std::vector<typename Queue::Entry> es(m.num_edges());
   xs.resize(m.num_edges());
 
-  // Trying parallel even if it repeats calculations. TODO: redo vertex-wise.
-  const auto task = [&](auto, auto e, auto end) {
-    for (; e < end; ++e) {
-      auto v0 = m.e2v[e * 2];
-      auto v1 = m.e2v[e * 2 + 1];
+  // Quadrics are summed and solved by batches of consecutive edges.
+  const auto task = [&](auto, auto e0, auto end) {
+    Quadric qs[OPTIMAL_POSITION_BATCH];
+    char is_solved[OPTIMAL_POSITION_BATCH];
+
+    for (; e0 < end; e0 += OPTIMAL_POSITION_BATCH) {
+      auto n = static_cast<int>(
+          std::min<Index>(OPTIMAL_POSITION_BATCH, end - e0));
 
       // Sum quadrics.
-      Quadric q;
-      q.A = vq[v0].A + vq[v1].A;
-      q.b = vq[v0].b + vq[v1].b;
-      q.c = vq[v0].c + vq[v1].c;
-
-      // Compute position.
-      Eigen::Vector3d x;
-      if (!get_optimal_position(q, x)) {
-        std::cout << "WARNING: Initial optimal position failed.\n";
-        Eigen::Vector3d x0{&m.v[v0 * 3]};
-        Eigen::Vector3d x1{&m.v[v1 * 3]};
-        x = (x0 + x1) * 0.5;
+      for (int i = 0; i < n; ++i)
+        qs[i] = vq[m.e2v[(e0 + i) * 2]] + vq[m.e2v[(e0 + i) * 2 + 1]];
+
+      // Compute positions.
+      get_optimal_positions(qs, n, &xs[e0], is_solved);
+
+      for (int i = 0; i < n; ++i) {
+        auto e = e0 + i;
+        if (!is_solved[i]) {
+          std::cout << "WARNING: Initial optimal position failed.\n";
+          Eigen::Vector3d x0 = to_vector3d(&m.v[m.e2v[e * 2] * 3]);
+          Eigen::Vector3d x1 = to_vector3d(&m.v[m.e2v[e * 2 + 1] * 3]);
+          xs[e] = get_edge_position(qs[i], x0, x1);
+        }
+
+        // Cost is always positive up to floating point arithmetic.
+        es[e] = {std::abs(qs[i](xs[e])), e};
       }
-
-      // Cost is always positive up to floating point arithmetic.
-      auto cost = std::abs(q(x));
-
-      eh[e] = std::make_tuple(cost, e, 0);
-      xs[e] = x;
     }
   };
-  utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_edges(), task);
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_edges()), task);
 
-  std::make_heap(eh.begin(), eh.end(), [](const auto& l, const auto& r) {
-    return std::get<0>(l) > std::get<0>(r);
-  });
+  eh = Queue(static_cast<Index>(m.num_edges()));
+  eh.assign(std::move(es));
 }
\ No newline at end of file
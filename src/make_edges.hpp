@@ -1,76 +1,114 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <numeric>
 #include <vector>
 
+#include "Adjacency.hpp"
 #include "Mesh.hpp"
+#include "make_inverse_adjacency.hpp"
+#include "parallel_radix_sort.hpp"
 #include "parallel_task.hpp"
 
-static void make_edges(Mesh& m) {
-  // Make edge to vertex connectivity.
-  {
-    std::vector<int> counts(utl::NUM_HARDWARE_THREADS, 0);
-    {
-      const auto task = [&](auto i, auto v, auto end) {
-        auto count = 0;
-        for (; v < end; ++v)
-          for (auto vv : m.v2v[v])
-            if (v < vv) ++count;
+// Make e2v, e2f and v2e from f2v alone. Every corner emits the half edge it
+// faces as (min vertex, max vertex, face), half edges are radix sorted on the
+// vertices (the sort is stable so faces stay sorted) and every run of equal
+// vertices is an edge. Edges come out sorted by vertices and their faces in
+// increasing order. Returns the number of non-manifold edges (more than two
+// faces), only their first two faces are kept in e2f.
+template <typename Scalar, typename Index>
+auto make_edges(BasicMesh<Scalar, Index>& m) {
+  struct HalfEdge {
+    Index v0;
+    Index v1;
+    Index f;
+  };
 
-        counts[i] = count;
-      };
-      utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_vertices(), task);
-    }
-    {
-      std::vector<int> offsets(counts.size(), 0);
-      std::partial_sum(counts.begin(), counts.end() - 1, offsets.begin() + 1);
+  auto num_corners = static_cast<Index>(m.f2v.size());
 
-      decltype(m.e2v)(std::reduce(counts.begin(), counts.end()) * 2)
-          .swap(m.e2v);
+  std::vector<HalfEdge> hs(num_corners);
+  {
+    const auto task = [&](auto, auto c, auto end) {
+      for (; c < end; ++c) {
+        auto v0 = m.f2v[c % 3 == 2 ? c - 2 : c + 1];
+        auto v1 = m.f2v[c % 3 == 0 ? c + 2 : c - 1];
+        hs[c] = {std::min(v0, v1), std::max(v0, v1), c / 3};
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_corners, task);
+  }
 
-      const auto task = [&](auto i, auto v, auto end) {
-        auto e = offsets[i];
-        for (; v < end; ++v)
-          for (auto vv : m.v2v[v]) {
-            if (v < vv) {
-              m.e2v[e * 2] = v;
-              m.e2v[e * 2 + 1] = vv;
-              ++e;
-            }
-          }
-      };
-      utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_vertices(), task);
-    }
+  // Only the bytes needed by the largest vertex index are sorted, max vertex
+  // first.
+  {
+    auto max_vertex =
+        static_cast<uint64_t>(std::max<size_t>(m.num_vertices(), 1) - 1);
+    int num_bytes = (std::bit_width(max_vertex) + 7) / 8;
+    const auto digit = [num_bytes](const HalfEdge& h, int d) {
+      auto v = static_cast<uint64_t>(d < num_bytes ? h.v1 : h.v0);
+      return static_cast<size_t>((v >> (8 * (d % num_bytes))) & 0xff);
+    };
+    utl::parallel_radix_sort(utl::NUM_HARDWARE_THREADS, hs, 2 * num_bytes,
+                             digit);
   }
 
-  // Make vertex to edge connectivity.
+  // An edge starts where the vertices change, half edges of degenerate faces
+  // (twice the same vertex) are skipped.
+  const auto is_start = [&](size_t i) {
+    return hs[i].v0 != hs[i].v1 &&
+           (i == 0 || hs[i].v0 != hs[i - 1].v0 || hs[i].v1 != hs[i - 1].v1);
+  };
+
+  // Count edges starting in the block of each thread, then fill each run from
+  // the block its start falls in (possibly reading past the block end).
+  std::vector<Index> counts(utl::NUM_HARDWARE_THREADS, 0);
   {
-    decltype(m.v2e)(m.num_vertices()).swap(m.v2e);
-    for (auto e = 0; e < m.num_edges(); ++e) {
-      m.v2e[m.e2v[e * 2]].push_back(e);
-      m.v2e[m.e2v[e * 2 + 1]].push_back(e);
-    }
+    const auto task = [&](auto i, auto begin, auto end) {
+      Index count = 0;
+      for (; begin < end; ++begin) count += is_start(begin);
+      counts[i] = count;
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, hs.size(), task);
   }
 
-  // Make edge to face connectivity (only for manifold meshes).
+  std::vector<Index> offsets(counts.size(), 0);
+  std::partial_sum(counts.begin(), counts.end() - 1, offsets.begin() + 1);
+  auto num_edges = std::reduce(counts.begin(), counts.end());
+
+  decltype(m.e2v)(num_edges * 2).swap(m.e2v);
+  decltype(m.e2f)(num_edges * 2, -1).swap(m.e2f);
+
+  std::vector<Index> num_non_manifold(counts.size(), 0);
   {
-    decltype(m.e2f)(m.e2v.size(), -1).swap(m.e2f);
-    const auto task = [&](auto, auto e, auto end) {
-      for (; e < end; ++e) {
-        auto v0 = m.e2v[e * 2];
-        auto v1 = m.e2v[e * 2 + 1];
+    const auto task = [&](auto i, auto begin, auto end) {
+      auto e = offsets[i];
+      for (; begin < end; ++begin) {
+        if (!is_start(begin)) continue;
 
-        // TODO: This is less efficient because it will scan the entire range
-        // (if manifold at most 2 flaps can be found, if non-manifold can cause
-        // problems with overwriting as there are more than 2 flaps).
-        auto it = std::set_intersection(m.v2f[v0].cbegin(), m.v2f[v0].cend(),
-                                        m.v2f[v1].cbegin(), m.v2f[v1].cend(),
-                                        &m.e2f[e * 2]);
-        // No more than 2 flaps for a manifold mesh.
-        assert(it <= &m.e2f[e * 2] + 2);
+        m.e2v[e * 2] = hs[begin].v0;
+        m.e2v[e * 2 + 1] = hs[begin].v1;
+
+        // A face appears twice on an edge if it is degenerate.
+        int num_faces = 0;
+        for (auto j = begin;
+             j < hs.size() && hs[j].v0 == hs[begin].v0 &&
+             hs[j].v1 == hs[begin].v1;
+             ++j) {
+          if (j != begin && hs[j].f == hs[j - 1].f) continue;
+          if (num_faces < 2) m.e2f[e * 2 + num_faces] = hs[j].f;
+          ++num_faces;
+        }
+        num_non_manifold[i] += num_faces > 2;
+        ++e;
       }
     };
-    utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_edges(), task);
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, hs.size(), task);
   }
-}
\ No newline at end of file
+
+  // Make vertex to edge connectivity.
+  make_inverse_adjacency<2>(m.e2v, m.num_vertices(), ADJACENCY_SLACK, m.v2e);
+
+  return std::reduce(num_non_manifold.begin(), num_non_manifold.end());
+}
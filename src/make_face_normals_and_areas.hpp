@@ -4,8 +4,10 @@
 
 #include "Mesh.hpp"
 #include "parallel_task.hpp"
+#include "to_vector3d.hpp"
 
-static void make_face_normals_and_areas(Mesh& m) {
+template <typename Scalar, typename Index>
+void make_face_normals_and_areas(BasicMesh<Scalar, Index>& m) {
   decltype(m.fn)(m.num_faces() * 3).swap(m.fn);
   decltype(m.fa)(m.num_faces()).swap(m.fa);
 
@@ -15,16 +17,18 @@ static void make_face_normals_and_areas(Mesh& m) {
       auto v1 = m.f2v[f * 3 + 1];
       auto v2 = m.f2v[f * 3 + 2];
 
-      Eigen::Vector3d x0{&m.v[v0 * 3]};
-      Eigen::Vector3d x1{&m.v[v1 * 3]};
-      Eigen::Vector3d x2{&m.v[v2 * 3]};
+      Eigen::Vector3d x0 = to_vector3d(&m.v[v0 * 3]);
+      Eigen::Vector3d x1 = to_vector3d(&m.v[v1 * 3]);
+      Eigen::Vector3d x2 = to_vector3d(&m.v[v2 * 3]);
 
-      Eigen::Map<Eigen::Vector3d> n{&m.fn[f * 3]};
-      n = (x1 - x0).cross(x2 - x0);
+      Eigen::Vector3d n = (x1 - x0).cross(x2 - x0);
       auto norm = n.norm();
       if (norm != 0.0) n /= norm;
+      Eigen::Map<Eigen::Matrix<Scalar, 3, 1>>{&m.fn[f * 3]} =
+          n.template cast<Scalar>();
       m.fa[f] = norm;
     }
   };
-  utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_faces(), task);
-}
\ No newline at end of file
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_faces()), task);
+}
@@ -8,8 +8,11 @@
 #include "Mesh.hpp"
 #include "Quadric.hpp"
 #include "parallel_task.hpp"
+#include "to_vector3d.hpp"
 
-auto make_face_quadrics(const Mesh& m) -> std::vector<Quadric> {
+template <typename Scalar, typename Index>
+auto make_face_quadrics(const BasicMesh<Scalar, Index>& m)
+    -> std::vector<Quadric> {
   assert(!m.fn.empty());
   assert(m.fn.size() % 3 == 0);
 
@@ -18,13 +21,18 @@ auto make_face_quadrics(const Mesh& m) -> std::vector<Quadric> {
   const auto task = [&](auto, auto f, auto end) {
     for (; f < end; ++f) {
       assert(m.fa[f] != 0.0);
-      Eigen::Map<const Eigen::Vector3d> n{&m.fn[f * 3]};
-      Eigen::Map<const Eigen::Vector3d> x0{&m.v[m.f2v[f * 3] * 3]};
+      Eigen::Vector3d n = to_vector3d(&m.fn[f * 3]);
+      Eigen::Vector3d x0 = to_vector3d(&m.v[m.f2v[f * 3] * 3]);
       assert(n != Eigen::Vector3d::Zero());
       fq[f] = make_quadric(n, x0);
     }
   };
-  utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_faces(), task);
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_faces()), task);
 
   return fq;
 }
+
+template auto make_face_quadrics(const Mesh&) -> std::vector<Quadric>;
+template auto make_face_quadrics(const FloatMesh&) -> std::vector<Quadric>;
+template auto make_face_quadrics(const LargeMesh&) -> std::vector<Quadric>;
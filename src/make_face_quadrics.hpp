@@ -5,4 +5,6 @@
 #include "Mesh.hpp"
 #include "Quadric.hpp"
 
-auto make_face_quadrics(const Mesh& m) -> std::vector<Quadric>;
\ No newline at end of file
+template <typename Scalar, typename Index>
+auto make_face_quadrics(const BasicMesh<Scalar, Index>& m)
+    -> std::vector<Quadric>;
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Adjacency.hpp"
+#include "parallel_task.hpp"
+
+// Invert a relation given as fixed size rows of N indices (e.g. f2v with N = 3
+// or e2v with N = 2) into the adjacency whose row y lists the rows x pointing
+// to y, in increasing order. Counting sort: every thread histograms the targets
+// of its block, the counts are scanned by thread within each row so that each
+// thread scatters its block to its own slots in order, which leaves the rows
+// sorted without atomics. Takes num_threads * num_y ints of scratch.
+template <int N, typename Index>
+void make_inverse_adjacency(const std::vector<Index>& x2y, size_t num_y,
+                            int slack, BasicAdjacency<Index>& y2x) {
+  auto n = static_cast<Index>(x2y.size());
+  auto num_threads = std::max(utl::NUM_HARDWARE_THREADS, 1u);
+
+  // Thread t counts into histograms[t * num_y, (t + 1) * num_y), unused
+  // histograms stay zero.
+  std::vector<int> histograms(num_threads * num_y, 0);
+  {
+    const auto task = [&](auto t, auto i, auto end) {
+      auto* h = histograms.data() + t * num_y;
+      for (; i < end; ++i) ++h[x2y[i]];
+    };
+    utl::parallel_task(num_threads, Index{0}, n, task);
+  }
+
+  // Row sizes, then the counts become the first slot of each thread in its row.
+  std::vector<int> sizes(num_y);
+  {
+    const auto task = [&](auto, auto y, auto end) {
+      for (; y < end; ++y) {
+        int offset = 0;
+        for (size_t t = 0; t < num_threads; ++t) {
+          auto count = histograms[t * num_y + y];
+          histograms[t * num_y + y] = offset;
+          offset += count;
+        }
+        sizes[y] = offset;
+      }
+    };
+    utl::parallel_task(num_threads, size_t{0}, num_y, task);
+  }
+
+  BasicAdjacency<Index> a(sizes, slack);
+
+  // Same split as the histogram.
+  {
+    auto* indices = a.data();
+    const auto& offsets = a.offsets();
+    const auto task = [&](auto t, auto i, auto end) {
+      auto* h = histograms.data() + t * num_y;
+      for (; i < end; ++i) {
+        auto y = x2y[i];
+        indices[offsets[y] + h[y]++] = i / N;
+      }
+    };
+    utl::parallel_task(num_threads, Index{0}, n, task);
+  }
+  for (size_t y = 0; y < num_y; ++y) a.resize(y, sizes[y]);
+
+  y2x.swap(a);
+}
@@ -1,58 +1,82 @@
 #pragma once
 
 #include <algorithm>
+#include <type_traits>
 #include <vector>
 
+#include "Adjacency.hpp"
 #include "Mesh.hpp"
+#include "make_inverse_adjacency.hpp"
 #include "parallel_task.hpp"
 
-static void make_topology(Mesh& m) {
+// Make v2f, v2v and f2f, the latter only if asked for as decimation does not
+// need it.
+template <typename Scalar, typename Index>
+void make_topology(BasicMesh<Scalar, Index>& m, bool with_f2f = true) {
+  auto num_vertices = static_cast<Index>(m.num_vertices());
+  auto num_faces = static_cast<Index>(m.num_faces());
+
   // Make vertex to face connectivity.
-  {
-    decltype(m.v2f)(m.num_vertices()).swap(m.v2f);
+  make_inverse_adjacency<3>(m.f2v, m.num_vertices(), ADJACENCY_SLACK, m.v2f);
 
-    for (auto f = 0; f < m.num_faces(); ++f) {
-      m.v2f[m.f2v[f * 3]].push_back(f);
-      m.v2f[m.f2v[f * 3 + 1]].push_back(f);
-      m.v2f[m.f2v[f * 3 + 2]].push_back(f);
+  // Make vertex to vertex and face to face connectivity in two parallel
+  // passes, the first counts the distinct neighbors of every element so that
+  // the second can write them straight into exactly sized rows. Neighbors are
+  // gathered in a buffer per thread.
+  const auto make = [](auto& adjacency, auto num_elements, int slack,
+                       const auto& gather) {
+    std::vector<int> sizes(num_elements);
+    {
+      const auto task = [&](auto, auto i, auto end) {
+        std::vector<Index> ns;
+        for (; i < end; ++i) {
+          gather(i, ns);
+          sizes[i] = ns.size();
+        }
+      };
+      utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_elements,
+                         task);
     }
-  }
 
-  // Make vertex to vertex connectivity.
-  {
-    decltype(m.v2v)(m.num_vertices()).swap(m.v2v);
+    std::remove_reference_t<decltype(adjacency)> a(sizes, slack);
+    {
+      const auto task = [&](auto, auto i, auto end) {
+        std::vector<Index> ns;
+        for (; i < end; ++i) {
+          gather(i, ns);
+          std::copy(ns.begin(), ns.end(), a.data() + a.offsets()[i]);
+          a.resize(i, ns.size());
+        }
+      };
+      utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0}, num_elements,
+                         task);
+    }
 
-    const auto task = [&](auto, auto v, auto end) {
-      for (; v < end; ++v) {
-        for (auto f : m.v2f[v])
-          for (const auto* vv = &m.f2v[f * 3]; vv < &m.f2v[f * 3] + 3; ++vv)
-            if (*vv != v) m.v2v[v].push_back(*vv);
+    adjacency.swap(a);
+  };
 
-        std::sort(m.v2v[v].begin(), m.v2v[v].end());
-        m.v2v[v].erase(std::unique(m.v2v[v].begin(), m.v2v[v].end()),
-                       m.v2v[v].end());
-      }
-    };
+  // Sorted distinct vertices of the faces around v other than v.
+  make(m.v2v, num_vertices, ADJACENCY_SLACK, [&](auto v, auto& ns) {
+    ns.clear();
+    for (auto f : m.v2f[v])
+      for (const auto* vv = &m.f2v[f * 3]; vv < &m.f2v[f * 3] + 3; ++vv)
+        if (*vv != v) ns.push_back(*vv);
+    std::sort(ns.begin(), ns.end());
+    ns.erase(std::unique(ns.begin(), ns.end()), ns.end());
+  });
 
-    utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_vertices(), task);
+  if (!with_f2f) {
+    m.f2f = {};
+    return;
   }
 
-  // Make face to face connectivity.
-  {
-    decltype(m.f2f)(m.num_faces()).swap(m.f2f);
-
-    const auto task = [&](auto, auto f, auto end) {
-      for (; f < end; ++f) {
-        for (const auto* v = &m.f2v[f * 3]; v < &m.f2v[f * 3] + 3; ++v)
-          for (auto ff : m.v2f[*v])
-            if (ff != f) m.f2f[f].push_back(ff);
-
-        std::sort(m.f2f[f].begin(), m.f2f[f].end());
-        m.f2f[f].erase(std::unique(m.f2f[f].begin(), m.f2f[f].end()),
-                       m.f2f[f].end());
-      }
-    };
-
-    utl::parallel_task(utl::NUM_HARDWARE_THREADS, 0, m.num_faces(), task);
-  }
-}
\ No newline at end of file
+  // Sorted distinct faces around the vertices of f other than f.
+  make(m.f2f, num_faces, 0, [&](auto f, auto& ns) {
+    ns.clear();
+    for (const auto* v = &m.f2v[f * 3]; v < &m.f2v[f * 3] + 3; ++v)
+      for (auto ff : m.v2f[*v])
+        if (ff != f) ns.push_back(ff);
+    std::sort(ns.begin(), ns.end());
+    ns.erase(std::unique(ns.begin(), ns.end()), ns.end());
+  });
+}
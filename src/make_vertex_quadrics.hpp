@@ -5,87 +5,150 @@
 #include <limits>
 #include <vector>
 
+#include "Adjacency.hpp"
+#include "CornerTable.hpp"
 #include "Mesh.hpp"
 #include "Quadric.hpp"
-
-static auto make_vertex_quadrics(const Mesh& m,
-                                 const std::vector<char>& is_boundary_edge,
-                                 const std::vector<char>& is_boundary_vertex) {
-  // Weight needed to not have degenerate quadrics in case of planar meshes.
-  constexpr auto WEIGHT = 1.0e-10;
-  // Weight needed to preserved boundaris by adding an orthogonal plane to
-  // boundary edges.
-  constexpr auto BOUNDARY_WEIGHT = 1.0e2;
-
-  // Return.
-  std::vector<Quadric> vq;
-  vq.reserve(m.num_vertices());
-
-  // Initialize vertex quadrics to handle degenerate cases.
-  for (auto v = 0; v < m.num_vertices(); ++v) {
-    auto x = Eigen::Vector3d{&m.v[v * 3]};
-
-    // Using c++20 emplace_back aggregate.
-    vq.emplace_back(
-        WEIGHT * Eigen::Matrix<double, 3, 3, Eigen::RowMajor>::Identity(),
-        -WEIGHT * x, WEIGHT * x.squaredNorm());
+#include "make_inverse_adjacency.hpp"
+#include "parallel_task.hpp"
+#include "to_vector3d.hpp"
+
+// Weight needed to not have degenerate quadrics in case of planar meshes.
+inline constexpr auto QUADRIC_WEIGHT = 1.0e-10;
+// Weight needed to preserved boundaris by adding an orthogonal plane to
+// boundary edges.
+inline constexpr auto BOUNDARY_QUADRIC_WEIGHT = 1.0e2;
+
+template <typename Scalar, typename Index>
+void add_face_quadric(Quadric& q, const BasicMesh<Scalar, Index>& m, Index f) {
+  if (m.fa[f] > std::numeric_limits<double>::epsilon()) {
+    Eigen::Vector3d n = to_vector3d(&m.fn[f * 3]);
+    Eigen::Vector3d x = to_vector3d(&m.v[m.f2v[f * 3] * 3]);
+    q += make_quadric(n, x);
   }
+}
+
+// Accumulate the quadrics of the faces around each vertex. Quadrics are always
+// in double precision whatever the scalar type of the mesh. Every vertex
+// gathers the quadrics of its faces from v2f in parallel, in increasing face
+// order so that the sums do not depend on the number of threads.
+template <typename Scalar, typename Index>
+auto make_vertex_quadrics(const BasicMesh<Scalar, Index>& m,
+                          const BasicAdjacency<Index>& v2f) {
+  // Return.
+  std::vector<Quadric> vq(m.num_vertices());
 
-  // Accumulate quadrics.
-  for (auto f = 0; f < m.num_faces(); ++f) {
-    Eigen::Vector3d n{&m.fn[f * 3]};
-    Eigen::Vector3d x{&m.v[m.f2v[f * 3] * 3]};
+  const auto task = [&](auto, auto v, auto end) {
+    for (; v < end; ++v) {
+      Eigen::Vector3d x = to_vector3d(&m.v[v * 3]);
 
-    if (m.fa[f] > std::numeric_limits<double>::epsilon()) {
-      auto q = make_quadric(n, x);
+      // Initialize vertex quadrics to handle degenerate cases.
+      vq[v] = make_point_quadric(x, QUADRIC_WEIGHT);
 
-      for (auto i = 0; i < 3; ++i) {
-        auto v = m.f2v[f * 3 + i];
-        vq[v].A += q.A;
-        vq[v].b += q.b;
-        vq[v].c += q.c;
-      }
+      // A face with two corners at v is listed and added twice.
+      for (auto f : v2f[v]) add_face_quadric(vq[v], m, f);
     }
-  }
+  };
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_vertices()), task);
 
-  // Boundary preservation quadrics.
-  for (auto e = 0; e < m.num_vertices(); ++e) {
-    if (!is_boundary_edge[e]) continue;
-
-    auto v0 = m.e2v[e * 2];
-    auto v1 = m.e2v[e * 2 + 1];
+  return vq;
+}
+
+// Same from the v2f of the mesh, or a temporary one if it has none.
+template <typename Scalar, typename Index>
+auto make_vertex_quadrics(const BasicMesh<Scalar, Index>& m) {
+  if (!m.v2f.empty()) return make_vertex_quadrics(m, m.v2f);
+
+  BasicAdjacency<Index> v2f;
+  make_inverse_adjacency<3>(m.f2v, m.num_vertices(), 0, v2f);
+  return make_vertex_quadrics(m, v2f);
+}
+
+// Add to q the quadric of the plane through the boundary edge (v0, v1) of face
+// f orthogonal to the face.
+template <typename Scalar, typename Index>
+void add_boundary_quadric(Quadric& q, const BasicMesh<Scalar, Index>& m,
+                          Index v0, Index v1, Index f) {
+  assert(v0 != v1);
+
+  Eigen::Vector3d x0 = to_vector3d(&m.v[v0 * 3]);
+  Eigen::Vector3d x1 = to_vector3d(&m.v[v1 * 3]);
+  auto s = x1 - x0;
+
+  Eigen::Vector3d fn = to_vector3d(&m.fn[f * 3]);
+  auto n = s.cross(fn);
+  auto norm = n.norm();
+
+  if (norm > std::numeric_limits<float>::epsilon()) {
+    n /= norm;
+    q += BOUNDARY_QUADRIC_WEIGHT * make_quadric(n, x0);
+  }
+}
 
-    assert(v0 != v1);
-    assert(is_boundary_vertex[v0]);
-    assert(is_boundary_vertex[v1]);
+// Boundary preservation quadrics gathered from v2e in increasing edge order.
+template <typename Scalar, typename Index>
+auto make_vertex_quadrics(const BasicMesh<Scalar, Index>& m,
+                          const std::vector<char>& is_boundary_edge,
+                          const std::vector<char>& is_boundary_vertex) {
+  auto vq = make_vertex_quadrics(m);
 
-    Eigen::Vector3d x0{&m.v[v0 * 3]};
-    Eigen::Vector3d x1{&m.v[v1 * 3]};
-    auto s = x1 - x0;
+  const auto task = [&](auto, auto v, auto end) {
+    for (; v < end; ++v) {
+      if (!is_boundary_vertex[v]) continue;
 
-    assert(m.e2f[e * 2] != -1);
-    assert(m.e2f[e * 2 + 1] == 1);
+      for (auto e : m.v2e[v]) {
+        if (!is_boundary_edge[e]) continue;
 
-    Eigen::Vector3d fn{&m.fn[m.e2f[e * 2] * 3]};
-    auto n = s.cross(fn);
-    auto norm = n.norm();
+        auto v0 = m.e2v[e * 2];
+        auto v1 = m.e2v[e * 2 + 1];
 
-    if (norm > std::numeric_limits<float>::epsilon()) {
-      n /= norm;
-      auto q = make_quadric(n, x0);
-      q.A *= BOUNDARY_WEIGHT;
-      q.b *= BOUNDARY_WEIGHT;
-      q.c *= BOUNDARY_WEIGHT;
+        assert(is_boundary_vertex[v0]);
+        assert(is_boundary_vertex[v1]);
+        assert(m.e2f[e * 2] != -1);
+        assert(m.e2f[e * 2 + 1] == -1);
 
-      vq[v0].A += q.A;
-      vq[v0].b += q.b;
-      vq[v0].c += q.c;
+        add_boundary_quadric(vq[v], m, v0, v1, m.e2f[e * 2]);
+      }
+    }
+  };
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_vertices()), task);
 
-      vq[v1].A += q.A;
-      vq[v1].b += q.b;
-      vq[v1].c += q.c;
+  return vq;
+}
+
+// Same on the corner table, boundary edges are faced by corners with no
+// opposite. Every vertex gathers them from the faces around it in increasing
+// corner order. The mesh has no v2f, a temporary one serves both gathers.
+template <typename Scalar, typename Index>
+auto make_vertex_quadrics(const BasicMesh<Scalar, Index>& m,
+                          const BasicCornerTable<Index>& ct) {
+  using CT = BasicCornerTable<Index>;
+
+  BasicAdjacency<Index> v2f;
+  make_inverse_adjacency<3>(m.f2v, m.num_vertices(), 0, v2f);
+
+  auto vq = make_vertex_quadrics(m, v2f);
+
+  const auto task = [&](auto, auto v, auto end) {
+    for (; v < end; ++v) {
+      // Faces with two corners at v are listed twice.
+      Index last = -1;
+      for (auto f : v2f[v]) {
+        if (f == last || m.fdel[f]) continue;
+        last = f;
+        for (auto c = f * 3; c < f * 3 + 3; ++c) {
+          auto v0 = m.f2v[CT::next(c)];
+          auto v1 = m.f2v[CT::prev(c)];
+          if (ct.o[c] == -1 && (v0 == v || v1 == v))
+            add_boundary_quadric(vq[v], m, v0, v1, f);
+        }
+      }
     }
-  }
+  };
+  utl::parallel_task(utl::NUM_HARDWARE_THREADS, Index{0},
+                     static_cast<Index>(m.num_vertices()), task);
 
   return vq;
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "parallel_task.hpp"
+
+namespace utl {
+
+// Stable LSD radix sort of items on num_digits digits of 8 bits, digit(x, d)
+// returns digit d (0 the least significant) of item x. Every pass histograms
+// the block of each thread in parallel, the counts are scanned digit major and
+// then by thread so that each thread scatters its block in order. Passes where
+// all the items have the same digit are skipped.
+template <typename T, typename Digit>
+void parallel_radix_sort(unsigned num_threads, std::vector<T>& items,
+                         int num_digits, Digit&& digit) {
+  using Histogram = std::array<size_t, 256>;
+
+  std::vector<T> buffer(items.size());
+  std::vector<Histogram> histograms(std::max(num_threads, 1u));
+
+  for (int d = 0; d < num_digits; ++d) {
+    {
+      const auto task = [&](auto i, auto begin, auto end) {
+        histograms[i].fill(0);
+        for (; begin < end; ++begin) ++histograms[i][digit(items[begin], d)];
+      };
+      parallel_task(num_threads, size_t{0}, items.size(), task);
+    }
+
+    auto is_constant = false;
+    for (size_t k = 0; k < 256 && !is_constant; ++k) {
+      size_t count = 0;
+      for (const auto& h : histograms) count += h[k];
+      is_constant = count == items.size();
+    }
+    if (is_constant) {
+      for (auto& h : histograms) h.fill(0);
+      continue;
+    }
+
+    // Unused histograms are empty, they only need to be zero.
+    size_t offset = 0;
+    for (size_t k = 0; k < 256; ++k)
+      for (auto& h : histograms) {
+        auto count = h[k];
+        h[k] = offset;
+        offset += count;
+      }
+
+    // Same split as the histogram.
+    {
+      const auto task = [&](auto i, auto begin, auto end) {
+        auto& h = histograms[i];
+        for (; begin < end; ++begin)
+          buffer[h[digit(items[begin], d)]++] = items[begin];
+      };
+      parallel_task(num_threads, size_t{0}, items.size(), task);
+    }
+
+    items.swap(buffer);
+    for (auto& h : histograms) h.fill(0);
+  }
+}
+
+}  // namespace utl
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "parallel_task.hpp"
+
+namespace utl {
+
+// Exclusive prefix sum of the n elements at first written to out (which can be
+// the same range) starting from init, returns the total. The range is split in
+// one block per thread, blocks are summed in parallel, the block sums are
+// scanned and then every block is scanned in parallel from its own offset.
+template <typename In, typename Out, typename T>
+T parallel_exclusive_scan(unsigned num_threads, In first, size_t n, Out out,
+                          T init) {
+  std::vector<T> sums(std::max(num_threads, 1u), T{});
+
+  const auto reduce = [&](auto i, auto begin, auto end) {
+    T sum{};
+    for (; begin < end; ++begin) sum += first[begin];
+    sums[i] = sum;
+  };
+  parallel_task(num_threads, size_t{0}, n, reduce);
+
+  for (auto& sum : sums) {
+    auto x = sum;
+    sum = init;
+    init += x;
+  }
+
+  // Same split as the reduction.
+  const auto scan = [&](auto i, auto begin, auto end) {
+    auto sum = sums[i];
+    for (; begin < end; ++begin) {
+      T x = first[begin];
+      out[begin] = sum;
+      sum += x;
+    }
+  };
+  parallel_task(num_threads, size_t{0}, n, scan);
+
+  return init;
+}
+
+}  // namespace utl
@@ -46,7 +46,7 @@ constexpr void custom_advance(Position& position, Count count) {
 template <typename Position, typename Count>
 constexpr auto custom_next(Position position, Count count) {
   if constexpr (std::is_integral_v<Position>)
-    return position + count;
+    return static_cast<Position>(position + count);
   else
     return std::next(position, count);
 }
@@ -54,12 +54,16 @@ constexpr auto custom_next(Position position, Count count) {
 }  // namespace
 
 // Use this switch for debugging.
-#if 0
+#if 1
 inline const auto NUM_HARDWARE_THREADS = std::thread::hardware_concurrency();
 #else
 inline const auto NUM_HARDWARE_THREADS = 1;
 #endif
 
+// Set while a thread works on a parallel task, nested parallel tasks then run
+// on the calling thread alone instead of oversubscribing the cores.
+inline thread_local bool IS_IN_PARALLEL_TASK = false;
+
 // Perform a parallel task on a range that can be given both as a pair of
 // iterators and as a pair of indices (in the latter case the range must be
 // contiguous), specify the number of threads or use the constant
@@ -72,13 +76,15 @@ inline const auto NUM_HARDWARE_THREADS = 1;
 // does its part of the work (so only num_threads-1 are instantiated). Begin and
 // End types can be iterators or integers and must be comparable. Returns the
 // number of threads that were actually used to execute the task in parallel or
-// 0 if the range is empty and no threads were used.
+// 0 if the range is empty and no threads were used. A parallel task started
+// from within another one runs serially.
 template <typename Begin, typename End, typename Task, typename... Args>
 auto parallel_task(unsigned num_threads, Begin begin, End end, Task&& task,
                    Args&&... args) {
   // Note that std::max and std::min require the same type in their arguments.
   num_threads =
       std::max(std::min(num_threads, std::thread::hardware_concurrency()), 1u);
+  if (IS_IN_PARALLEL_TASK) num_threads = 1;
   assert(num_threads >= 1);
 
   auto n = custom_distance(begin, end);
@@ -90,18 +96,26 @@ auto parallel_task(unsigned num_threads, Begin begin, End end, Task&& task,
   std::vector<std::thread> threads(num_threads - 1);
 
   auto begin_loc = begin;
-  auto index = 0;
+  decltype(remainder) index = 0;
   for (auto& t : threads) {
     // Only the first few threads do extra work.
     if (index == remainder) nloc -= 1;
     // Each thread receives copies of the arguments, so reference wrappers are
     // needed to have the same semantic of references.
-    t = std::thread(task, index, begin_loc, custom_next(begin_loc, nloc),
-                    custom_forward<Args>(args)...);
+    t = std::thread(
+        [&task](auto&&... thread_args) {
+          IS_IN_PARALLEL_TASK = true;
+          task(std::move(thread_args)...);
+        },
+        index, begin_loc, custom_next(begin_loc, nloc),
+        custom_forward<Args>(args)...);
     custom_advance(begin_loc, nloc);
     ++index;
   }
+  auto was_in_parallel_task = IS_IN_PARALLEL_TASK;
+  IS_IN_PARALLEL_TASK = true;
   task(index, begin_loc, end, custom_forward<Args>(args)...);
+  IS_IN_PARALLEL_TASK = was_in_parallel_task;
 
   for (auto& t : threads) t.join();
 
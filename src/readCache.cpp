@@ -0,0 +1,159 @@
+#include "readCache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Adjacency.hpp"
+#include "Mesh.hpp"
+#include "MeshCache.hpp"
+
+namespace {
+
+// Cursor over the blocks of a mapped cache file.
+class BlockReader {
+ public:
+  BlockReader(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+  bool good() const { return good_; }
+
+  template <typename T>
+  std::pair<const T*, uint64_t> next() {
+    uint64_t count = 0;
+    if (!good_ || end_ - p_ < static_cast<std::ptrdiff_t>(sizeof(count))) {
+      good_ = false;
+      return {nullptr, 0};
+    }
+    std::memcpy(&count, p_, sizeof(count));
+    p_ += sizeof(count);
+
+    // Check the count before multiplying so a corrupt one cannot wrap around.
+    auto remaining = static_cast<uint64_t>(end_ - p_);
+    if (count > remaining / sizeof(T) ||
+        cache::padded(count * sizeof(T)) > remaining) {
+      good_ = false;
+      return {nullptr, 0};
+    }
+    // Blocks are 8-byte aligned relative to the page aligned mapping.
+    const auto* ptr = reinterpret_cast<const T*>(p_);
+    p_ += cache::padded(count * sizeof(T));
+    return {ptr, count};
+  }
+
+  template <typename T>
+  void read(std::vector<T>& buf) {
+    auto [ptr, count] = next<T>();
+    buf.assign(ptr, ptr + count);
+  }
+
+  void read_adjacency(Adjacency& rel) {
+    std::vector<uint64_t> offsets;
+    std::vector<int> sizes, capacities, indices;
+    read(offsets);
+    read(sizes);
+    read(capacities);
+    read(indices);
+    if (!good_ || sizes.size() != offsets.size() ||
+        capacities.size() != offsets.size()) {
+      good_ = false;
+      return;
+    }
+
+    for (size_t i = 0; i < offsets.size(); ++i)
+      if (sizes[i] < 0 || sizes[i] > capacities[i] ||
+          offsets[i] > indices.size() ||
+          static_cast<uint64_t>(capacities[i]) > indices.size() - offsets[i]) {
+        good_ = false;
+        return;
+      }
+
+    Adjacency(std::move(offsets), std::move(sizes), std::move(capacities),
+              std::move(indices))
+        .swap(rel);
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+  bool good_ = true;
+};
+
+}  // namespace
+
+bool readCache(std::string_view filepath, Mesh& m) {
+  MappedFile file(filepath);
+
+  if (!file.is_open()) {
+    std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
+    return false;
+  }
+
+  cache::Header header;
+  if (file.size() < sizeof(header)) {
+    std::fprintf(stderr, "ERROR: \"%s\" is not a mesh cache.\n",
+                 filepath.data());
+    return false;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+
+  if (std::memcmp(header.magic, cache::MAGIC, sizeof(cache::MAGIC)) != 0) {
+    std::fprintf(stderr, "ERROR: \"%s\" is not a mesh cache.\n",
+                 filepath.data());
+    return false;
+  }
+  if (header.version != cache::VERSION) {
+    std::fprintf(stderr, "ERROR: Mesh cache version %u, expected %u.\n",
+                 header.version, cache::VERSION);
+    return false;
+  }
+
+  BlockReader r(file.begin() + sizeof(header), file.end());
+
+  r.read(m.v);
+  r.read(m.t);
+  r.read(m.n);
+  r.read(m.f2v);
+  r.read(m.f2t);
+  r.read(m.f2n);
+
+  if (header.flags & cache::TOPOLOGY) {
+    r.read_adjacency(m.v2f);
+    r.read_adjacency(m.v2v);
+    r.read_adjacency(m.f2f);
+    r.read(m.e2v);
+    r.read_adjacency(m.v2e);
+    r.read(m.e2f);
+  }
+
+  if (header.flags & cache::NORMALS_AND_AREAS) {
+    r.read(m.fn);
+    r.read(m.fa);
+  }
+
+  if (!r.good()) {
+    std::fprintf(stderr, "ERROR: Truncated mesh cache \"%s\".\n",
+                 filepath.data());
+    return false;
+  }
+
+  // Indices are trusted by everything downstream.
+  auto in_range = [](const std::vector<int>& x2y, size_t n) {
+    return std::all_of(x2y.begin(), x2y.end(), [n](int y) {
+      return y >= 0 && static_cast<size_t>(y) < n;
+    });
+  };
+  auto num_vertices = m.num_vertices();
+  if (m.v.size() % 3 || m.f2v.size() % 3 || m.e2v.size() % 2 ||
+      !in_range(m.f2v, num_vertices) || !in_range(m.e2v, num_vertices)) {
+    std::fprintf(stderr, "ERROR: Corrupt mesh cache \"%s\".\n",
+                 filepath.data());
+    return false;
+  }
+
+  return true;
+}
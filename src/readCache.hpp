@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string_view>
+
+#include "Mesh.hpp"
+
+// Read a mesh written by writeCache. Connectivity relations and face normals
+// and areas are restored only if present in the file, in which case there is
+// no need to call make_topology, make_edges or make_face_normals_and_areas.
+bool readCache(std::string_view filepath, Mesh& m);
@@ -1,153 +1,334 @@
 #include "readOBJ.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <charconv>
 #include <cstdio>
-#include <iostream>  // debug
+#include <cstdlib>
+#include <functional>
 #include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#include "MappedFile.hpp"
 #include "Mesh.hpp"
+#include "parallel_task.hpp"
 
-static void parse_vertex(const char* line, Mesh& m) {
-  std::array<double, 3> x;
+namespace {
 
-  if (std::sscanf(line, " v %lf %lf %lf", &x[0], &x[1], &x[2]) != 3) {
-    std::fprintf(stderr, "ERROR: Bad vertex format.\n");
-    std::exit(EXIT_FAILURE);
-  }
+// Number of elements of each buffer, triangles are counted for the face
+// buffers (polygons are fan triangulated).
+struct Counts {
+  size_t v = 0;
+  size_t t = 0;
+  size_t n = 0;
+  size_t f2v = 0;
+  size_t f2t = 0;
+  size_t f2n = 0;
 
-  m.v.insert(m.v.end(), x.begin(), x.end());
-}
+  Counts& operator+=(const Counts& c) {
+    v += c.v;
+    t += c.t;
+    n += c.n;
+    f2v += c.f2v;
+    f2t += c.f2t;
+    f2n += c.f2n;
+    return *this;
+  }
+};
 
-static void parse_texture(const char* line, Mesh& m) {
-  std::array<double, 2> tx;
+// Chunks smaller than this are not worth a thread.
+constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
 
-  if (std::sscanf(line, " vt %lf %lf", &tx[0], &tx[1]) != 2) {
-    std::fprintf(stderr, "ERROR: Bad texture format.\n");
-    std::exit(EXIT_FAILURE);
-  }
+[[noreturn]] void fail(const char* message) {
+  std::fprintf(stderr, "ERROR: %s\n", message);
+  std::exit(EXIT_FAILURE);
+}
 
-  m.t.insert(m.t.end(), tx.begin(), tx.end());
+// Skip spaces, tabs and carriage returns but never the line ending.
+const char* skip_blanks(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+  return p;
 }
 
-static void parse_normal(const char* line, Mesh& m) {
-  std::array<double, 3> nx;
+const char* skip_line(const char* p, const char* end) {
+  while (p < end && *p != '\n') ++p;
+  return p < end ? p + 1 : end;
+}
 
-  if (std::sscanf(line, " vn %lf %lf %lf", &nx[0], &nx[1], &nx[2]) != 3) {
-    std::fprintf(stderr, "ERROR: Bad normal format.\n");
-    std::exit(EXIT_FAILURE);
-  }
+bool is_line_end(const char* p, const char* end) {
+  return p == end || *p == '\n' || *p == '#';
+}
 
-  m.n.insert(m.n.end(), nx.begin(), nx.end());
+template <typename T>
+const char* parse_number(const char* p, const char* end, T& x,
+                         const char* message) {
+  p = skip_blanks(p, end);
+  // Unlike strtod from_chars does not accept an explicit plus sign.
+  if (p < end && *p == '+') ++p;
+  auto [ptr, ec] = std::from_chars(p, end, x);
+  if (ec != std::errc{}) fail(message);
+  return ptr;
 }
 
-static auto parse_indices(const char* p, int& offset) {
-  // Order is vertex, texture, normal.
-  std::array<int, 3> i{0, 0, 0};
-
-  // Match in sscanf the trailing whitespaces to move the offset to the null
-  // character if the line has ended (skipping \r\n). Also the order of pattern
-  // matching matters, first more specific v/t/n than less v/t to avoid
-  // premature matching. TODO: This may not be the best way to this honestly
-  // have to measure perf.
-  if (std::sscanf(p, " %d/%d/%d %n", &i[0], &i[1], &i[2], &offset) == 3) {
-  } else if (std::sscanf(p, " %d/%d %n", &i[0], &i[1], &offset) == 2) {
-  } else if (std::sscanf(p, " %d//%d %n", &i[0], &i[2], &offset) == 2) {
-  } else if (std::sscanf(p, " %d %n", &i[0], &offset) == 1) {
-  } else {
-    // WARNING: This does not catch all errors.
-    std::fprintf(stderr, "ERROR: Bad index format.\n");
-    std::exit(EXIT_FAILURE);
+// Parse a corner of a face in any of the forms v, v/t, v//n, v/t/n. Missing
+// indices are left to zero which is never a valid OBJ index.
+template <typename Index>
+const char* parse_indices(const char* p, const char* end,
+                          std::array<Index, 3>& i) {
+  i = {0, 0, 0};
+  p = parse_number(p, end, i[0], "Bad index format.");
+  if (p < end && *p == '/') {
+    ++p;
+    if (p < end && *p != '/')
+      p = parse_number(p, end, i[1], "Bad index format.");
+    if (p < end && *p == '/')
+      p = parse_number(p + 1, end, i[2], "Bad index format.");
   }
-  return i;
+  return p;
 }
 
-static void parse_face(const char* line, Mesh& m) {
-  ++line;
-  int offset = 0;
+// Cheap pass that only looks at the line headers and at the separators of the
+// face corners to size the buffers exactly.
+Counts count_elements(const char* p, const char* end) {
+  Counts c;
 
-  auto i0 = parse_indices(line, offset);
-  line += offset;
+  while (p < end) {
+    if (p[0] == 'v' && p + 1 < end) {
+      switch (p[1]) {
+        case ' ':
+        case '\t':
+          ++c.v;
+          break;
+        case 't':
+          ++c.t;
+          break;
+        case 'n':
+          ++c.n;
+          break;
+      }
+    } else if (p[0] == 'f') {
+      const char* q = skip_blanks(p + 1, end);
+      size_t num_corners = 0;
+      auto num_slashes = 0;
+      auto has_texture = false;
 
-  // Face must at least be a triangle.
-  if (*line == '\0') {
-    std::fprintf(stderr, "ERROR: Face has too few indices.\n");
-    std::exit(EXIT_FAILURE);
-  }
+      while (!is_line_end(q, end)) {
+        // Only the first corner decides which index buffers are filled.
+        if (num_corners == 0)
+          for (const char* r = q; r < end && *r > ' '; ++r)
+            if (*r == '/') {
+              if (++num_slashes == 1 && r + 1 < end && r[1] != '/')
+                has_texture = true;
+            }
 
-  auto i1 = parse_indices(line, offset);
-  line += offset;
+        while (q < end && *q > ' ') ++q;
+        q = skip_blanks(q, end);
+        ++num_corners;
+      }
 
-  // Face must at least be a triangle.
-  if (*line == '\0') {
-    std::fprintf(stderr, "ERROR: Face has too few indices.\n");
-    std::exit(EXIT_FAILURE);
-  }
+      if (num_corners < 3) fail("Face has too few indices.");
 
-  // Here all trailing whitespaces have to be consumed to check for line ending.
-  while (*line != '\0') {
-    auto i2 = parse_indices(line, offset);
-    line += offset;
-
-    // Perform simple fan triangulation and zero-based reindexing.
-    if (i0[0] > 0)
-      m.f2v.insert(m.f2v.end(), {i0[0] - 1, i1[0] - 1, i2[0] - 1});
-    else if (i0[0] < 0) {
-      int nv = m.v.size() / 3;
-      m.f2v.insert(m.f2v.end(), {i0[0] + nv, i1[0] + nv, i2[0] + nv});
-    } else {
-      std::fprintf(stderr, "ERROR: Bad face format.\n");
-      std::exit(EXIT_FAILURE);
+      auto num_triangles = num_corners - 2;
+      c.f2v += num_triangles;
+      if (has_texture) c.f2t += num_triangles;
+      if (num_slashes == 2) c.f2n += num_triangles;
     }
 
-    if (i0[1] > 0)
-      m.f2t.insert(m.f2t.end(), {i0[1] - 1, i1[1] - 1, i2[1] - 1});
-    else if (i0[1] < 0) {
-      int nt = m.t.size() / 3;
-      m.f2t.insert(m.f2t.end(), {i0[1] + nt, i1[1] + nt, i2[1] + nt});
-    }
+    p = skip_line(p, end);
+  }
 
-    if (i0[2] > 0)
-      m.f2n.insert(m.f2n.end(), {i0[2] - 1, i1[2] - 1, i2[2] - 1});
-    else if (i0[2] < 0) {
-      int nn = m.n.size() / 3;
-      m.f2n.insert(m.f2n.end(), {i0[2] + nn, i1[2] + nn, i2[2] + nn});
-    }
+  return c;
+}
 
-    // Rotate.
-    i1 = i2;
-  }
+// Resolve a one-based or relative (negative) index against the number of
+// elements declared so far.
+template <typename Index>
+Index resolve(Index i, size_t count) {
+  if (i > 0) return i - 1;
+  return i + static_cast<Index>(count);
 }
 
-void readOBJ(std::string_view filepath, Mesh& m) {
-  std::FILE* file = std::fopen(filepath.data(), "rb");
-
-  char line[512];
-
-  if (file) {
-    while (std::fgets(line, 512, file)) {
-      switch (line[0]) {
-        case 'v':
-          switch (line[1]) {
-            case ' ':
-            case '\t':
-              parse_vertex(line, m);
-              break;
-            case 't':
-              parse_texture(line, m);
-              break;
-            case 'n':
-              parse_normal(line, m);
-              break;
-          }
+// Parse the lines in [p, end) writing the elements starting at the positions
+// given by at, offset plus at tell how many elements precede the range.
+template <typename Scalar, typename Index>
+void parse_elements(const char* p, const char* end, BasicMesh<Scalar, Index>& m,
+                    Counts at, const Counts& offset = {}) {
+  while (p < end) {
+    if (p[0] == 'v' && p + 1 < end) {
+      switch (p[1]) {
+        case ' ':
+        case '\t': {
+          auto* x = &m.v[at.v++ * 3];
+          const char* q = p + 1;
+          for (auto k = 0; k < 3; ++k)
+            q = parse_number(q, end, x[k], "Bad vertex format.");
+          break;
+        }
+        case 't': {
+          auto* x = &m.t[at.t++ * 2];
+          const char* q = p + 2;
+          for (auto k = 0; k < 2; ++k)
+            q = parse_number(q, end, x[k], "Bad texture format.");
           break;
-        case 'f':
-          parse_face(line, m);
+        }
+        case 'n': {
+          auto* x = &m.n[at.n++ * 3];
+          const char* q = p + 2;
+          for (auto k = 0; k < 3; ++k)
+            q = parse_number(q, end, x[k], "Bad normal format.");
           break;
+        }
+      }
+    } else if (p[0] == 'f') {
+      std::array<Index, 3> i0, i1, i2;
+      const char* q = parse_indices(p + 1, end, i0);
+      q = parse_indices(q, end, i1);
+      q = skip_blanks(q, end);
+
+      if (i0[0] == 0) fail("Bad face format.");
+
+      while (!is_line_end(q, end)) {
+        q = skip_blanks(parse_indices(q, end, i2), end);
+
+        // Perform simple fan triangulation and zero-based reindexing.
+        auto* f = &m.f2v[at.f2v++ * 3];
+        f[0] = resolve(i0[0], offset.v + at.v);
+        f[1] = resolve(i1[0], offset.v + at.v);
+        f[2] = resolve(i2[0], offset.v + at.v);
+
+        if (i0[1] != 0) {
+          auto* f = &m.f2t[at.f2t++ * 3];
+          f[0] = resolve(i0[1], offset.t + at.t);
+          f[1] = resolve(i1[1], offset.t + at.t);
+          f[2] = resolve(i2[1], offset.t + at.t);
+        }
+
+        if (i0[2] != 0) {
+          auto* f = &m.f2n[at.f2n++ * 3];
+          f[0] = resolve(i0[2], offset.n + at.n);
+          f[1] = resolve(i1[2], offset.n + at.n);
+          f[2] = resolve(i2[2], offset.n + at.n);
+        }
+
+        // Rotate.
+        i1 = i2;
       }
     }
-  } else
+
+    p = skip_line(p, end);
+  }
+}
+
+// Split the file in about num_chunks ranges that start at the beginning of a
+// line, returns the num_chunks + 1 boundaries.
+std::vector<const char*> split_lines(const char* begin, const char* end,
+                                     size_t num_chunks) {
+  std::vector<const char*> bounds{begin};
+  auto size = static_cast<size_t>(end - begin);
+  for (size_t i = 1; i < num_chunks; ++i) {
+    const char* p = std::max(begin + size * i / num_chunks, bounds.back());
+    // Move to the beginning of the next line (p - 1 may be a line ending).
+    while (p > begin && p < end && p[-1] != '\n') ++p;
+    bounds.push_back(p);
+  }
+  bounds.push_back(end);
+  return bounds;
+}
+
+// Count the elements of every chunk, the exclusive scan of the counts gives
+// where each chunk writes and how many elements precede it, which also
+// resolves relative indices across chunks. Returns the scan and the total.
+std::pair<std::vector<Counts>, Counts> count_chunks(
+    const std::vector<const char*>& bounds, Counts total,
+    unsigned num_threads) {
+  auto num_chunks = bounds.size() - 1;
+  std::vector<Counts> at(num_chunks);
+
+  const auto task = [&](auto, auto i, auto end) {
+    for (; i < end; ++i) at[i] = count_elements(bounds[i], bounds[i + 1]);
+  };
+  utl::parallel_task(num_threads, size_t{0}, num_chunks, task);
+
+  for (auto& c : at) {
+    auto count = c;
+    c = total;
+    total += count;
+  }
+
+  return {at, total};
+}
+
+}  // namespace
+
+template <typename Scalar, typename Index>
+void readOBJ(std::string_view filepath, BasicMesh<Scalar, Index>& m,
+             unsigned num_threads) {
+  MappedFile file(filepath);
+
+  if (!file.is_open()) {
     std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
+    return;
+  }
 
-  std::fclose(file);
-}
\ No newline at end of file
+  auto num_chunks = std::clamp<size_t>(file.size() / MIN_CHUNK_SIZE, 1,
+                                       std::max(num_threads, 1u));
+  auto bounds = split_lines(file.begin(), file.end(), num_chunks);
+
+  // Append to whatever the mesh already contains.
+  auto [at, total] = count_chunks(
+      bounds, Counts{m.v.size() / 3, m.t.size() / 2, m.n.size() / 3,
+                     m.f2v.size() / 3, m.f2t.size() / 3, m.f2n.size() / 3},
+      num_threads);
+
+  // Single allocation per buffer.
+  m.v.resize(total.v * 3);
+  m.t.resize(total.t * 2);
+  m.n.resize(total.n * 3);
+  m.f2v.resize(total.f2v * 3);
+  m.f2t.resize(total.f2t * 3);
+  m.f2n.resize(total.f2n * 3);
+
+  // Chunks write disjoint ranges of the buffers.
+  const auto task = [&](auto, auto i, auto end) {
+    for (; i < end; ++i) parse_elements(bounds[i], bounds[i + 1], m, at[i]);
+  };
+  utl::parallel_task(num_threads, size_t{0}, num_chunks, task);
+}
+
+template void readOBJ(std::string_view, Mesh&, unsigned);
+template void readOBJ(std::string_view, FloatMesh&, unsigned);
+template void readOBJ(std::string_view, LargeMesh&, unsigned);
+
+void readOBJ_chunks(
+    std::string_view filepath, size_t chunk_size,
+    const std::function<void(const Mesh&, size_t)>& process) {
+  MappedFile file(filepath);
+
+  if (!file.is_open()) {
+    std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
+    return;
+  }
+
+  auto num_chunks =
+      std::max<size_t>(file.size() / std::max<size_t>(chunk_size, 1), 1);
+  auto bounds = split_lines(file.begin(), file.end(), num_chunks);
+  auto [offsets, total] =
+      count_chunks(bounds, Counts{}, utl::NUM_HARDWARE_THREADS);
+
+  Mesh chunk;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    auto c = (i + 1 < num_chunks ? offsets[i + 1] : total);
+    chunk.v.resize((c.v - offsets[i].v) * 3);
+    chunk.t.resize((c.t - offsets[i].t) * 2);
+    chunk.n.resize((c.n - offsets[i].n) * 3);
+    chunk.f2v.resize((c.f2v - offsets[i].f2v) * 3);
+    chunk.f2t.resize((c.f2t - offsets[i].f2t) * 3);
+    chunk.f2n.resize((c.f2n - offsets[i].f2n) * 3);
+
+    parse_elements(bounds[i], bounds[i + 1], chunk, Counts{}, offsets[i]);
+    process(chunk, offsets[i].v);
+  }
+}
@@ -1,7 +1,22 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <string_view>
 
 #include "Mesh.hpp"
+#include "parallel_task.hpp"
 
-void readOBJ(std::string_view filepath, Mesh& m);
+// The file is split at line boundaries into chunks that are parsed
+// concurrently directly into the mesh buffers. Instantiated for Mesh,
+// FloatMesh and LargeMesh.
+template <typename Scalar, typename Index>
+void readOBJ(std::string_view filepath, BasicMesh<Scalar, Index>& m,
+             unsigned num_threads = utl::NUM_HARDWARE_THREADS);
+
+// Parse the file in chunks of about chunk_size bytes calling process(chunk,
+// first) for each of them in order, where chunk only holds the elements
+// declared in that part of the file and first is the number of vertices
+// declared before it. Face indices are global.
+void readOBJ_chunks(std::string_view filepath, size_t chunk_size,
+                    const std::function<void(const Mesh&, size_t)>& process);
@@ -0,0 +1,331 @@
+#include "readPLY.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+
+namespace {
+
+enum class Type { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+struct Property {
+  std::string name;
+  Type type;
+  // Only set for list properties, type is then the item type.
+  bool is_list = false;
+  Type count_type;
+};
+
+struct Element {
+  std::string name;
+  size_t count;
+  std::vector<Property> properties;
+};
+
+// Format errors unwind to readPLY, which reports them.
+struct FormatError {
+  const char* message;
+};
+
+[[noreturn]] void fail(const char* message) { throw FormatError{message}; }
+
+Type parse_type(const std::string& s) {
+  if (s == "char" || s == "int8") return Type::INT8;
+  if (s == "uchar" || s == "uint8") return Type::UINT8;
+  if (s == "short" || s == "int16") return Type::INT16;
+  if (s == "ushort" || s == "uint16") return Type::UINT16;
+  if (s == "int" || s == "int32") return Type::INT32;
+  if (s == "uint" || s == "uint32") return Type::UINT32;
+  if (s == "float" || s == "float32") return Type::FLOAT32;
+  if (s == "double" || s == "float64") return Type::FLOAT64;
+  fail("Bad PLY property type.");
+}
+
+size_t size_of(Type type) {
+  switch (type) {
+    case Type::INT8:
+    case Type::UINT8:
+      return 1;
+    case Type::INT16:
+    case Type::UINT16:
+      return 2;
+    case Type::INT32:
+    case Type::UINT32:
+    case Type::FLOAT32:
+      return 4;
+    case Type::FLOAT64:
+      return 8;
+  }
+  return 0;
+}
+
+template <typename T>
+T load(const char* p) {
+  T x;
+  std::memcpy(&x, p, sizeof(T));
+  return x;
+}
+
+template <typename T>
+T read_as(const char* p, Type type) {
+  switch (type) {
+    case Type::INT8:
+      return static_cast<T>(load<int8_t>(p));
+    case Type::UINT8:
+      return static_cast<T>(load<uint8_t>(p));
+    case Type::INT16:
+      return static_cast<T>(load<int16_t>(p));
+    case Type::UINT16:
+      return static_cast<T>(load<uint16_t>(p));
+    case Type::INT32:
+      return static_cast<T>(load<int32_t>(p));
+    case Type::UINT32:
+      return static_cast<T>(load<uint32_t>(p));
+    case Type::FLOAT32:
+      return static_cast<T>(load<float>(p));
+    case Type::FLOAT64:
+      return static_cast<T>(load<double>(p));
+  }
+  return T{};
+}
+
+// Returns the size of a record starting at p checking that it fits in the
+// file.
+size_t record_size(const Element& e, const char* p, const char* end) {
+  size_t size = 0;
+  for (const auto& prop : e.properties) {
+    if (p + size + size_of(prop.is_list ? prop.count_type : prop.type) > end)
+      fail("Truncated PLY file.");
+    if (prop.is_list) {
+      auto count = read_as<size_t>(p + size, prop.count_type);
+      size += size_of(prop.count_type) + count * size_of(prop.type);
+    } else
+      size += size_of(prop.type);
+  }
+  if (p + size > end) fail("Truncated PLY file.");
+  return size;
+}
+
+// Parse the header and return the position of the binary data.
+const char* parse_header(const MappedFile& file,
+                         std::vector<Element>& elements) {
+  std::string_view text{file.data(), file.size()};
+  auto pos = text.find("end_header");
+  if (text.substr(0, 3) != "ply" || pos == std::string_view::npos)
+    fail("Bad PLY header.");
+  pos = text.find('\n', pos);
+  if (pos == std::string_view::npos) fail("Bad PLY header.");
+
+  std::istringstream iss{std::string{text.substr(0, pos)}};
+  std::string line;
+  while (std::getline(iss, line)) {
+    std::istringstream ls{line};
+    std::string keyword;
+    ls >> keyword;
+
+    if (keyword == "format") {
+      std::string format;
+      ls >> format;
+      if (format != "binary_little_endian")
+        fail("Only binary little-endian PLY files are supported.");
+    } else if (keyword == "element") {
+      auto& e = elements.emplace_back();
+      ls >> e.name >> e.count;
+    } else if (keyword == "property") {
+      if (elements.empty()) fail("Bad PLY header.");
+      Property prop;
+      std::string type;
+      ls >> type;
+      if (type == "list") {
+        std::string count_type;
+        ls >> count_type >> type;
+        prop.is_list = true;
+        prop.count_type = parse_type(count_type);
+      }
+      prop.type = parse_type(type);
+      ls >> prop.name;
+      elements.back().properties.push_back(prop);
+    }
+  }
+
+  return file.data() + pos + 1;
+}
+
+template <typename Scalar, typename Index>
+const char* read_vertices(const Element& e, const char* p, const char* end,
+                          BasicMesh<Scalar, Index>& m) {
+  constexpr const char* names[3] = {"x", "y", "z"};
+
+  // Byte offsets of the coordinates inside a record.
+  size_t stride = 0;
+  size_t offsets[3];
+  Type types[3];
+  auto found = 0;
+  for (const auto& prop : e.properties) {
+    if (prop.is_list)
+      fail("List properties in PLY vertices are not supported.");
+    for (auto k = 0; k < 3; ++k)
+      if (prop.name == names[k]) {
+        offsets[k] = stride;
+        types[k] = prop.type;
+        ++found;
+      }
+    stride += size_of(prop.type);
+  }
+  if (found != 3) fail("PLY vertices need x, y and z properties.");
+
+  if (static_cast<size_t>(end - p) < e.count * stride)
+    fail("Truncated PLY file.");
+
+  auto nv = m.v.size();
+  m.v.resize(nv + e.count * 3);
+  auto* x = &m.v[nv];
+
+  // Same layout as the mesh buffer.
+  constexpr auto type = sizeof(Scalar) == 4 ? Type::FLOAT32 : Type::FLOAT64;
+  if (stride == 3 * sizeof(Scalar) && offsets[0] == 0 &&
+      offsets[1] == sizeof(Scalar) && offsets[2] == 2 * sizeof(Scalar) &&
+      types[0] == type && types[1] == type && types[2] == type) {
+    std::memcpy(x, p, e.count * stride);
+  } else {
+    for (size_t i = 0; i < e.count; ++i)
+      for (auto k = 0; k < 3; ++k)
+        *x++ = read_as<Scalar>(p + i * stride + offsets[k], types[k]);
+  }
+
+  return p + e.count * stride;
+}
+
+// Face indices are offset by the vertices already in the mesh (base) and must
+// refer to one of the num_vertices of the file.
+template <typename Scalar, typename Index>
+const char* read_faces(const Element& e, const char* p, const char* end,
+                       size_t base, size_t num_vertices,
+                       BasicMesh<Scalar, Index>& m) {
+  const Property* list = nullptr;
+  size_t before = 0;
+  for (const auto& prop : e.properties) {
+    if (prop.is_list &&
+        (prop.name == "vertex_indices" || prop.name == "vertex_index")) {
+      list = &prop;
+      break;
+    }
+    if (prop.is_list) fail("Unsupported list property in PLY faces.");
+    before += size_of(prop.type);
+  }
+  if (!list) fail("PLY faces need a vertex_indices property.");
+
+  // Triangles are copied with a single memcpy if the indices are 32-bit like
+  // the mesh ones.
+  auto is_int32 = sizeof(Index) == 4 &&
+                  (list->type == Type::INT32 || list->type == Type::UINT32);
+  auto count_size = size_of(list->count_type);
+  auto item_size = size_of(list->type);
+  auto is_simple = e.properties.size() == 1;
+
+  // Most faces are triangles.
+  auto first = m.f2v.size();
+  m.f2v.reserve(first + e.count * 3);
+
+  for (size_t i = 0; i < e.count; ++i) {
+    auto size = is_simple ? 0 : record_size(e, p, end);
+    const char* q = p + before;
+    if (q + count_size > end) fail("Truncated PLY file.");
+    auto count = read_as<size_t>(q, list->count_type);
+    q += count_size;
+    if (is_simple) {
+      size = count_size + count * item_size;
+      if (p + size > end) fail("Truncated PLY file.");
+    }
+
+    if (count < 3) fail("Face has too few indices.");
+
+    if (count == 3 && is_int32) {
+      auto f = m.f2v.size();
+      m.f2v.resize(f + 3);
+      std::memcpy(&m.f2v[f], q, 3 * sizeof(Index));
+    } else {
+      // Perform simple fan triangulation.
+      auto i0 = read_as<Index>(q, list->type);
+      auto i1 = read_as<Index>(q + item_size, list->type);
+      for (size_t k = 2; k < count; ++k) {
+        auto i2 = read_as<Index>(q + k * item_size, list->type);
+        m.f2v.insert(m.f2v.end(), {i0, i1, i2});
+        i1 = i2;
+      }
+    }
+
+    p += size;
+  }
+
+  for (auto i = first; i < m.f2v.size(); ++i) {
+    auto& v = m.f2v[i];
+    if (v < 0 || static_cast<size_t>(v) >= num_vertices)
+      fail("Face index out of range.");
+    v += static_cast<Index>(base);
+  }
+
+  return p;
+}
+
+}  // namespace
+
+template <typename Scalar, typename Index>
+bool readPLY(std::string_view filepath, BasicMesh<Scalar, Index>& m) {
+  if constexpr (std::endian::native != std::endian::little) {
+    std::fprintf(stderr, "ERROR: Reading PLY requires a little-endian host.\n");
+    return false;
+  }
+
+  MappedFile file(filepath);
+
+  if (!file.is_open()) {
+    std::fprintf(stderr, "ERROR: Could not open \"%s\".\n", filepath.data());
+    return false;
+  }
+
+  // The mesh is left as it was on failure.
+  auto base = m.num_vertices();
+  auto first = m.f2v.size();
+  try {
+    std::vector<Element> elements;
+    const char* p = parse_header(file, elements);
+
+    // The vertex element may follow the faces.
+    size_t num_vertices = 0;
+    for (const auto& e : elements)
+      if (e.name == "vertex") num_vertices += e.count;
+
+    for (const auto& e : elements) {
+      if (e.name == "vertex")
+        p = read_vertices(e, p, file.end(), m);
+      else if (e.name == "face")
+        p = read_faces(e, p, file.end(), base, num_vertices, m);
+      else
+        for (size_t i = 0; i < e.count; ++i)
+          p += record_size(e, p, file.end());
+    }
+
+    if (m.f2v.size() == first) fail("No faces in PLY file.");
+  } catch (const FormatError& error) {
+    std::fprintf(stderr, "ERROR: %s\n", error.message);
+    m.v.resize(base * 3);
+    m.f2v.resize(first);
+    return false;
+  }
+
+  return true;
+}
+
+template bool readPLY(std::string_view, Mesh&);
+template bool readPLY(std::string_view, FloatMesh&);
+template bool readPLY(std::string_view, LargeMesh&);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string_view>
+
+#include "Mesh.hpp"
+
+// Read a binary little-endian PLY file, only vertex positions and face
+// vertex indices are loaded (polygons are fan triangulated). Instantiated for
+// Mesh, FloatMesh and LargeMesh. Returns false, with an error printed and the
+// mesh left unchanged, if the file cannot be opened or is malformed.
+template <typename Scalar, typename Index>
+bool readPLY(std::string_view filepath, BasicMesh<Scalar, Index>& m);
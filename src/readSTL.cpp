@@ -0,0 +1,121 @@
+#include "readSTL.hpp"
+
+#include <robin_hood.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 80 + sizeof(uint32_t);
+// Normal, 3 vertices and attribute byte count.
+constexpr size_t TRIANGLE_SIZE = 12 * sizeof(float) + sizeof(uint16_t);
+
+// Vertices are welded on the bits of the float coordinates.
+using Key = std::array<uint32_t, 3>;
+
+struct KeyHash {
+  size_t operator()(const Key& k) const {
+    return robin_hood::hash_bytes(k.data(), sizeof(Key));
+  }
+};
+
+Key make_key(const char* p) {
+  Key k;
+  std::memcpy(k.data(), p, sizeof(Key));
+  // Treat -0.0 and 0.0 as the same coordinate.
+  for (auto& x : k)
+    if (x == 0x80000000u) x = 0;
+  return k;
+}
+
+}  // namespace
+
+template <typename Scalar, typename Index>
+bool readSTL(std::string_view filepath, BasicMesh<Scalar, Index>& m) {
+  if constexpr (std::endian::native != std::endian::little) {
+    std::fprintf(stderr,
+                 "ERROR: Reading STL files requires a little-endian host.\n");
+    return false;
+  }
+
+  MappedFile file(filepath);
+
+  if (!file.is_open()) {
+    std::fprintf(stderr, "ERROR: Could not open \"%s\".\n", filepath.data());
+    return false;
+  }
+
+  uint32_t num_triangles = 0;
+  if (file.size() >= HEADER_SIZE)
+    std::memcpy(&num_triangles, file.data() + 80, sizeof(num_triangles));
+
+  // ASCII files start with "solid" but so can binary headers, so rely on the
+  // size: it has to match the triangle count exactly, or exceed it (some
+  // exporters pad the file) without the start of the file reading like ASCII.
+  auto size = HEADER_SIZE + size_t{num_triangles} * TRIANGLE_SIZE;
+  std::string_view start{file.data(), std::min<size_t>(file.size(), 512)};
+  auto is_ascii = start.starts_with("solid") &&
+                  start.find("facet") != std::string_view::npos;
+  if (file.size() < HEADER_SIZE || file.size() < size ||
+      (file.size() > size && is_ascii)) {
+    std::fprintf(stderr, "ERROR: Only binary STL files are supported.\n");
+    return false;
+  }
+
+  // A closed triangle mesh has about half as many vertices as triangles.
+  robin_hood::unordered_flat_map<Key, Index, KeyHash> map;
+  map.reserve(num_triangles / 2);
+
+  Index nv = m.v.size() / 3;
+  m.v.reserve(m.v.size() + num_triangles / 2 * 3);
+  m.f2v.reserve(m.f2v.size() + num_triangles * 3);
+
+  auto num_degenerate = 0;
+  const char* p = file.data() + HEADER_SIZE;
+  for (uint32_t i = 0; i < num_triangles; ++i, p += TRIANGLE_SIZE) {
+    std::array<Index, 3> f;
+
+    for (auto k = 0; k < 3; ++k) {
+      const char* x = p + (k + 1) * 3 * sizeof(float);
+      auto [it, inserted] = map.insert({make_key(x), nv});
+      if (inserted) {
+        std::array<float, 3> y;
+        std::memcpy(y.data(), x, sizeof(y));
+        m.v.insert(m.v.end(), y.begin(), y.end());
+        ++nv;
+      }
+      f[k] = it->second;
+    }
+
+    // Triangles collapsed by the welding cannot enter the topology.
+    if (f[0] == f[1] || f[1] == f[2] || f[2] == f[0]) {
+      ++num_degenerate;
+      continue;
+    }
+
+    m.f2v.insert(m.f2v.end(), f.begin(), f.end());
+  }
+
+  if (num_degenerate > 0)
+    std::fprintf(stderr, "WARNING: Skipped %d degenerate triangles.\n",
+                 num_degenerate);
+
+  if (m.f2v.empty()) {
+    std::fprintf(stderr, "ERROR: No triangles in \"%s\".\n", filepath.data());
+    return false;
+  }
+  return true;
+}
+
+template bool readSTL(std::string_view, Mesh&);
+template bool readSTL(std::string_view, FloatMesh&);
+template bool readSTL(std::string_view, LargeMesh&);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string_view>
+
+#include "Mesh.hpp"
+
+// Read a binary STL file welding bit-identical vertices while triangles are
+// streamed, so the mesh comes out indexed without a separate deduplication.
+// Returns false, with an error printed, if the file cannot be read or holds no
+// triangle. Instantiated for Mesh, FloatMesh and LargeMesh.
+template <typename Scalar, typename Index>
+bool readSTL(std::string_view filepath, BasicMesh<Scalar, Index>& m);
@@ -3,11 +3,13 @@
 #include <cassert>
 #include <vector>
 
+#include "CornerTable.hpp"
 #include "Mesh.hpp"
 
-static bool test_collapse_boundaries(
-    const Mesh& m, int e, const std::vector<char>& is_boundary_edge,
-    const std::vector<char>& is_boundary_vertex) {
+template <typename Scalar, typename Index>
+bool test_collapse_boundaries(const BasicMesh<Scalar, Index>& m, Index e,
+                              const std::vector<char>& is_boundary_edge,
+                              const std::vector<char>& is_boundary_vertex) {
   auto v0 = m.e2v[e * 2];
   auto v1 = m.e2v[e * 2 + 1];
 
@@ -16,4 +18,18 @@ static bool test_collapse_boundaries(
     return false;
 
   return true;
-}
\ No newline at end of file
+}
+
+// Same test for the edge faced by corner c.
+template <typename Scalar, typename Index>
+bool test_collapse_boundaries(const BasicMesh<Scalar, Index>& m,
+                              const BasicCornerTable<Index>& ct, Index c) {
+  auto v0 = m.f2v[ct.next(c)];
+  auto v1 = m.f2v[ct.prev(c)];
+
+  if (ct.is_boundary_vertex(v0) && ct.is_boundary_vertex(v1) &&
+      ct.o[c] != -1)
+    return false;
+
+  return true;
+}
@@ -7,11 +7,57 @@
 #include <tuple>
 #include <vector>
 
+#include "CornerTable.hpp"
 #include "Mesh.hpp"
+#include "to_vector3d.hpp"
 
-static bool test_collapse_normal_flipping(
-    const Mesh& m, int e, const double* x, double tol,
-    std::vector<std::tuple<int, Eigen::Vector3d, double>>& ns) {
+// Compute the normal of face f once vertex v is moved to x and append it to ns
+// together with its norm, return false if it turns by more than acos(tol).
+template <typename Scalar, typename Index>
+bool test_face_normal_flipping(
+    const BasicMesh<Scalar, Index>& m, Index f, Index v, const double* x,
+    double tol, std::vector<std::tuple<Index, Eigen::Vector3d, double>>& ns) {
+  const auto position = [&](auto i) -> Eigen::Vector3d {
+    if (v == m.f2v[f * 3 + i]) return Eigen::Vector3d{x};
+    return to_vector3d(&m.v[m.f2v[f * 3 + i] * 3]);
+  };
+
+  auto x0 = position(0);
+  auto x1 = position(1);
+  auto x2 = position(2);
+
+  assert(x0 != x1);
+  assert(x0 != x2);
+  assert(x1 != x2);
+
+  ns.push_back({f, (x1 - x0).cross(x2 - x0), 0.0});
+  auto& n = std::get<1>(ns.back());
+  auto& norm = std::get<2>(ns.back());
+  norm = n.norm();
+
+  // If mesh starts without null normals it should not ever have null
+  // normals.
+  if (norm == 0.0 || m.fa[f] == 0.0) {
+    std::cerr << "WARNING: Null normals while testing for normal "
+                 "flipping.\n";
+    return false;
+  }
+  assert(norm != 0.0);
+  assert(m.fa[f] != 0.0);
+
+  n /= norm;
+
+  // Reject collapse if the old to new normal cosine is less than a
+  // tolerance.
+  if (n.dot(to_vector3d(&m.fn[f * 3])) < tol) return false;
+
+  return true;
+}
+
+template <typename Scalar, typename Index>
+bool test_collapse_normal_flipping(
+    const BasicMesh<Scalar, Index>& m, Index e, const double* x, double tol,
+    std::vector<std::tuple<Index, Eigen::Vector3d, double>>& ns) {
   assert(!m.edel[e]);
 
   auto v0 = m.e2v[e * 2];
@@ -33,39 +79,39 @@ static bool test_collapse_normal_flipping(
     for (auto f : m.v2f[v]) {
       if (f == f0 || f == f1 || m.fdel[f]) continue;
 
-      Eigen::Vector3d x0{v == m.f2v[f * 3] ? x : &m.v[m.f2v[f * 3] * 3]};
-      Eigen::Vector3d x1{v == m.f2v[f * 3 + 1] ? x
-                                               : &m.v[m.f2v[f * 3 + 1] * 3]};
-      Eigen::Vector3d x2{v == m.f2v[f * 3 + 2] ? x
-                                               : &m.v[m.f2v[f * 3 + 2] * 3]};
-
-      assert(x0 != x1);
-      assert(x0 != x2);
-      assert(x1 != x2);
-
-      ns.push_back({f, (x1 - x0).cross(x2 - x0), 0.0});
-      auto& n = std::get<1>(ns.back());
-      auto& norm = std::get<2>(ns.back());
-      norm = n.norm();
-
-      // If mesh starts without null normals it should not ever have null
-      // normals.
-      if (norm == 0.0 || m.fa[f] == 0.0) {
-        std::cerr << "WARNING: Null normals while testing for normal "
-                     "flipping.\n";
-        return false;
-      }
-      assert(norm != 0.0);
-      assert(m.fa[f] != 0.0);
-
-      n /= norm;
-
-      // Reject collapse if the old to new normal cosine is less than a
-      // tolerance.
-      if (n.dot(Eigen::Map<const Eigen::Vector3d>{&m.fn[f * 3]}) < tol)
-        return false;
+      if (!test_face_normal_flipping(m, f, v, x, tol, ns)) return false;
     }
   }
 
   return true;
-}
\ No newline at end of file
+}
+
+// Same test for the edge faced by corner c, the faces around both vertices are
+// visited by swinging.
+template <typename Scalar, typename Index>
+bool test_collapse_normal_flipping(
+    const BasicMesh<Scalar, Index>& m, const BasicCornerTable<Index>& ct,
+    Index c, const double* x, double tol,
+    std::vector<std::tuple<Index, Eigen::Vector3d, double>>& ns) {
+  assert(!m.fdel[ct.face(c)]);
+
+  auto v0 = m.f2v[ct.next(c)];
+  auto v1 = m.f2v[ct.prev(c)];
+  auto f0 = ct.face(c);
+  auto f1 = ct.o[c] == -1 ? Index{-1} : ct.face(ct.o[c]);
+
+  assert(v0 != v1);
+  assert(f0 != f1);
+
+  auto is_valid = true;
+  for (auto v : {v0, v1}) {
+    ct.for_each_corner(v, [&](auto e) {
+      auto f = ct.face(e);
+      if (!is_valid || f == f0 || f == f1) return;
+      is_valid = test_face_normal_flipping(m, f, v, x, tol, ns);
+    });
+    if (!is_valid) return false;
+  }
+
+  return true;
+}
@@ -4,11 +4,13 @@
 #include <cassert>
 #include <vector>
 
+#include "CornerTable.hpp"
 #include "Mesh.hpp"
 
 // WARNING: Highly inefficent.
-static bool test_collapse_shared_neighbors(
-    const Mesh& m, int e, const std::vector<char>& is_boundary_edge) {
+template <typename Scalar, typename Index>
+bool test_collapse_shared_neighbors(const BasicMesh<Scalar, Index>& m, Index e,
+                                    const std::vector<char>& is_boundary_edge) {
   assert(!m.edel[e]);
 
   auto v0 = m.e2v[e * 2];
@@ -31,4 +33,54 @@ static bool test_collapse_shared_neighbors(
 
   return (!is_boundary_edge[e] && num_shared < 3) ||
          (is_boundary_edge[e] && num_shared < 2);
-}
\ No newline at end of file
+}
+
+// Same test for the edge faced by corner c, the two one-rings are gathered by
+// swinging around the vertices so this runs in O(valence log valence).
+template <typename Scalar, typename Index>
+bool test_collapse_shared_neighbors(const BasicMesh<Scalar, Index>& m,
+                                    const BasicCornerTable<Index>& ct,
+                                    Index c) {
+  assert(!m.fdel[ct.face(c)]);
+
+  auto v0 = m.f2v[ct.next(c)];
+  auto v1 = m.f2v[ct.prev(c)];
+
+  assert(v0 != v1);
+  assert(!m.vdel[v0]);
+  assert(!m.vdel[v1]);
+
+  const auto ring = [&](auto v, auto skip) {
+    std::vector<Index> vs;
+    ct.for_each_corner(v, [&](auto e) {
+      vs.push_back(m.f2v[ct.next(e)]);
+      vs.push_back(m.f2v[ct.prev(e)]);
+    });
+    std::sort(vs.begin(), vs.end());
+    vs.erase(std::unique(vs.begin(), vs.end()), vs.end());
+    vs.erase(std::remove(vs.begin(), vs.end(), skip), vs.end());
+    return vs;
+  };
+
+  auto r0 = ring(v0, v1);
+  auto r1 = ring(v1, v0);
+
+  auto num_shared = 0;
+  for (auto i = r0.begin(), j = r1.begin(); i != r0.end() && j != r1.end();) {
+    if (*i < *j) {
+      ++i;
+    } else if (*j < *i) {
+      ++j;
+    } else {
+      ++num_shared;
+      ++i;
+      ++j;
+    }
+  }
+
+  assert(num_shared >= 1);
+
+  auto is_boundary_edge = ct.o[c] == -1;
+  return (!is_boundary_edge && num_shared < 3) ||
+         (is_boundary_edge && num_shared < 2);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <Eigen/Core>
+
+// View 3 coordinates of any scalar type as a double precision vector, which is
+// what normals, quadrics and optimal positions are computed in.
+template <typename Scalar>
+auto to_vector3d(const Scalar* x) {
+  return Eigen::Map<const Eigen::Matrix<Scalar, 3, 1>>{x}
+      .template cast<double>();
+}
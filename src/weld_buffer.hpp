@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "disjoint_set.hpp"
+#include "parallel_radix_sort.hpp"
+#include "parallel_task.hpp"
+
+// Weld the elements of SIZE values of a buffer (positions, normals, texture
+// coordinates) closer than epsilon in euclidean distance, or bit identical up
+// to the sign of zero if epsilon is 0. Merging is transitive and every group
+// is represented by its first element. As with find_buffer_duplicates the
+// others are marked as duplicated and indices maps every element to its
+// representative, ready for compress_buffer. Elements are keyed by their cell
+// in a grid of spacing epsilon (by their bits if exact), the keys are radix
+// sorted in parallel and every element is compared with the ones after it in
+// its cell and in the neighboring cells after its own, pairs within epsilon
+// being joined in a lock-free disjoint set. Coordinates over epsilon must fit
+// in 64-bit integers.
+template <size_t SIZE, typename Value, typename Bool, typename Index = int>
+void weld_buffer(const Value* buf, size_t count, double epsilon,
+                 Bool* duplicated, Index* indices) {
+  static_assert(SIZE > 0);
+  assert(buf);
+  assert(duplicated);
+  assert(indices);
+  assert(epsilon >= 0.0);
+
+  using Key = std::array<uint64_t, SIZE>;
+  struct Item {
+    Key key;
+    Index i;
+  };
+
+  auto is_exact = epsilon == 0.0;
+
+  // Cells are biased to keep their order as unsigned, adding zero turns -0
+  // into +0.
+  std::vector<Item> items(count);
+  {
+    const auto task = [&](auto, auto i, auto end) {
+      for (; i < end; ++i) {
+        for (size_t k = 0; k < SIZE; ++k) {
+          double x = static_cast<double>(buf[i * SIZE + k]) + 0.0;
+          items[i].key[k] =
+              is_exact ? std::bit_cast<uint64_t>(x)
+                       : static_cast<uint64_t>(
+                             static_cast<int64_t>(std::floor(x / epsilon))) +
+                             (uint64_t{1} << 63);
+        }
+        items[i].i = static_cast<Index>(i);
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, count, task);
+  }
+
+  // Keys relative to their minimum, sorted only on the bytes needed.
+  {
+    std::vector<std::pair<Key, Key>> ranges(
+        std::max(utl::NUM_HARDWARE_THREADS, 1u));
+    for (auto& [min, max] : ranges) {
+      min.fill(std::numeric_limits<uint64_t>::max());
+      max.fill(0);
+    }
+    const auto task = [&](auto t, auto i, auto end) {
+      auto& [min, max] = ranges[t];
+      for (; i < end; ++i)
+        for (size_t k = 0; k < SIZE; ++k) {
+          min[k] = std::min(min[k], items[i].key[k]);
+          max[k] = std::max(max[k], items[i].key[k]);
+        }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, count, task);
+
+    auto [min, max] = ranges[0];
+    for (const auto& [tmin, tmax] : ranges)
+      for (size_t k = 0; k < SIZE; ++k) {
+        min[k] = std::min(min[k], tmin[k]);
+        max[k] = std::max(max[k], tmax[k]);
+      }
+
+    // Least significant first: the bytes of the last coordinate.
+    std::vector<std::pair<size_t, int>> digits;
+    for (auto k = SIZE; k-- > 0;)
+      if (max[k] >= min[k]) {
+        auto num_bits = static_cast<int>(std::bit_width(max[k] - min[k]));
+        for (auto b = 0; b < (num_bits + 7) / 8; ++b) digits.emplace_back(k, b);
+      }
+
+    const auto rebase = [&](auto, auto i, auto end) {
+      for (; i < end; ++i)
+        for (size_t k = 0; k < SIZE; ++k) items[i].key[k] -= min[k];
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, count, rebase);
+
+    const auto digit = [&](const Item& item, int d) {
+      auto [k, b] = digits[d];
+      return static_cast<size_t>((item.key[k] >> (8 * b)) & 0xff);
+    };
+    utl::parallel_radix_sort(utl::NUM_HARDWARE_THREADS, items,
+                             static_cast<int>(digits.size()), digit);
+  }
+
+  const auto is_close = [&](Index i, Index j) {
+    if (is_exact) return true;
+    double d2 = 0.0;
+    for (size_t k = 0; k < SIZE; ++k) {
+      double d = static_cast<double>(buf[i * SIZE + k]) - buf[j * SIZE + k];
+      d2 += d * d;
+    }
+    return d2 <= epsilon * epsilon;
+  };
+
+  // Offsets of the neighboring cells after the cell itself in key order (first
+  // nonzero offset positive), none if exact.
+  std::vector<std::array<int, SIZE>> offsets;
+  if (!is_exact) {
+    std::array<int, SIZE> d;
+    d.fill(-1);
+    while (true) {
+      auto first = std::find_if(d.begin(), d.end(), [](auto x) { return x; });
+      if (first != d.end() && *first > 0) offsets.push_back(d);
+      auto k = SIZE;
+      while (k > 0 && d[k - 1] == 1) d[--k] = -1;
+      if (k == 0) break;
+      ++d[k - 1];
+    }
+  }
+
+  std::vector<Index> parent(count);
+  std::iota(parent.begin(), parent.end(), Index{0});
+  {
+    const auto key_less = [](const Item& item, const Key& key) {
+      return item.key < key;
+    };
+    const auto task = [&](auto, auto p, auto end) {
+      for (; p < end; ++p) {
+        const auto& item = items[p];
+
+        // Same cell.
+        for (auto q = p + 1; q < count && items[q].key == item.key; ++q)
+          if (is_close(item.i, items[q].i))
+            disjoint_set_unite(parent, item.i, items[q].i);
+
+        for (const auto& d : offsets) {
+          Key key = item.key;
+          // Cells below the minimum hold nothing, wrapping is harmless above.
+          auto is_valid = true;
+          for (size_t k = 0; k < SIZE; ++k) {
+            is_valid &= d[k] >= 0 || key[k] > 0;
+            key[k] += d[k];
+          }
+          if (!is_valid) continue;
+
+          auto q = std::lower_bound(items.begin() + p + 1, items.end(), key,
+                                    key_less);
+          for (; q < items.end() && q->key == key; ++q)
+            if (is_close(item.i, q->i))
+              disjoint_set_unite(parent, item.i, q->i);
+        }
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, count, task);
+  }
+
+  {
+    const auto task = [&](auto, auto i, auto end) {
+      for (; i < end; ++i) {
+        indices[i] = disjoint_set_find(parent, static_cast<Index>(i));
+        duplicated[i] = indices[i] != static_cast<Index>(i);
+      }
+    };
+    utl::parallel_task(utl::NUM_HARDWARE_THREADS, size_t{0}, count, task);
+  }
+}
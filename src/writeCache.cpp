@@ -0,0 +1,76 @@
+#include "writeCache.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "Adjacency.hpp"
+#include "Mesh.hpp"
+#include "MeshCache.hpp"
+
+namespace {
+
+template <typename T>
+void write_block(std::FILE* file, const T* ptr, uint64_t count) {
+  constexpr char zeros[8] = {};
+  std::fwrite(&count, sizeof(count), 1, file);
+  if (count) std::fwrite(ptr, sizeof(T), count, file);
+  auto num_bytes = count * sizeof(T);
+  std::fwrite(zeros, 1, cache::padded(num_bytes) - num_bytes, file);
+}
+
+template <typename T>
+void write_block(std::FILE* file, const std::vector<T>& buf) {
+  write_block(file, buf.data(), buf.size());
+}
+
+void write_adjacency(std::FILE* file, const Adjacency& rel) {
+  write_block(file, rel.offsets());
+  write_block(file, rel.sizes());
+  write_block(file, rel.capacities());
+  write_block(file, rel.indices());
+}
+
+}  // namespace
+
+void writeCache(std::string_view filepath, const Mesh& m) {
+  std::FILE* file = std::fopen(filepath.data(), "wb");
+
+  if (!file) {
+    std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
+    return;
+  }
+
+  cache::Header header{};
+  std::memcpy(header.magic, cache::MAGIC, sizeof(cache::MAGIC));
+  header.version = cache::VERSION;
+  if (!m.v2f.empty() && !m.e2v.empty()) header.flags |= cache::TOPOLOGY;
+  if (m.fn.size() == m.num_faces() * 3 && m.fa.size() == m.num_faces())
+    header.flags |= cache::NORMALS_AND_AREAS;
+  std::fwrite(&header, sizeof(header), 1, file);
+
+  write_block(file, m.v);
+  write_block(file, m.t);
+  write_block(file, m.n);
+  write_block(file, m.f2v);
+  write_block(file, m.f2t);
+  write_block(file, m.f2n);
+
+  if (header.flags & cache::TOPOLOGY) {
+    write_adjacency(file, m.v2f);
+    write_adjacency(file, m.v2v);
+    write_adjacency(file, m.f2f);
+    write_block(file, m.e2v);
+    write_adjacency(file, m.v2e);
+    write_block(file, m.e2f);
+  }
+
+  if (header.flags & cache::NORMALS_AND_AREAS) {
+    write_block(file, m.fn);
+    write_block(file, m.fa);
+  }
+
+  std::fclose(file);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string_view>
+
+#include "Mesh.hpp"
+
+// Write the mesh in the binary cache format read by readCache. The geometry is
+// always written, the connectivity relations and the face normals and areas
+// only if they have been built.
+void writeCache(std::string_view filepath, const Mesh& m);
@@ -1,62 +1,128 @@
 #include "writeOBJ.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <charconv>
 #include <cstdio>
-#include <iostream>  // debug
+#include <limits>
 #include <string_view>
+#include <vector>
 
-void writeOBJ(std::string_view filepath, Mesh& m) {
+#include "parallel_task.hpp"
+
+namespace {
+
+// Number of lines formatted by a thread before flushing.
+constexpr size_t BLOCK_SIZE = 1 << 16;
+
+// Longest shortest-representation double is 24 characters (float is 15).
+constexpr int MAX_DOUBLE_SIZE = 32;
+
+// Sign and digits.
+template <typename Index>
+constexpr int MAX_INDEX_SIZE = std::numeric_limits<Index>::digits10 + 2;
+
+template <typename Scalar>
+char* format_scalar(char* p, Scalar x, int precision) {
+  auto* end = p + MAX_DOUBLE_SIZE + std::max(precision, 0);
+  if (precision < 0) return std::to_chars(p, end, x).ptr;
+  return std::to_chars(p, end, x, std::chars_format::general, precision).ptr;
+}
+
+template <typename Index>
+char* format_index(char* p, Index i) {
+  return std::to_chars(p, p + MAX_INDEX_SIZE<Index>, i + 1).ptr;
+}
+
+// Format count lines of at most max_line_size characters with format(p, i),
+// which writes line i at p and returns the end of it. Each thread fills its
+// own buffer with a block of lines, buffers are then written in order.
+template <typename Format>
+void write_lines(std::FILE* file, size_t count, size_t max_line_size,
+                 const Format& format, unsigned num_threads) {
+  num_threads = std::max(num_threads, 1u);
+  std::vector<std::vector<char>> bufs(num_threads);
+  std::vector<size_t> sizes(num_threads, 0);
+
+  // First line of the current round of blocks.
+  size_t first = 0;
+
+  const auto task = [&](auto, auto b, auto end) {
+    for (; b < end; ++b) {
+      auto& buf = bufs[b];
+      buf.resize(BLOCK_SIZE * max_line_size);
+      auto* p = buf.data();
+      auto begin = first + b * BLOCK_SIZE;
+      auto last = std::min(begin + BLOCK_SIZE, count);
+      for (auto i = begin; i < last; ++i) p = format(p, i);
+      sizes[b] = p - buf.data();
+    }
+  };
+
+  for (; first < count; first += num_threads * BLOCK_SIZE) {
+    auto num_blocks = std::min<size_t>(
+        num_threads, (count - first + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    utl::parallel_task(num_threads, size_t{0}, num_blocks, task);
+    for (size_t b = 0; b < num_blocks; ++b)
+      std::fwrite(bufs[b].data(), 1, sizes[b], file);
+  }
+}
+
+}  // namespace
+
+template <typename Scalar, typename Index>
+void writeOBJ(std::string_view filepath, BasicMesh<Scalar, Index>& m,
+              int precision, unsigned num_threads) {
   assert(m.num_vertices() > 0);
   assert(m.num_faces() > 0);
 
   std::FILE* file = std::fopen(filepath.data(), "wb");
 
-  if (file) {
-    for (auto v = 0; v < m.num_vertices(); ++v) {
-      std::fprintf(file, "v %lf %lf %lf\n", m.v[v * 3], m.v[v * 3 + 1],
-                   m.v[v * 3 + 2]);
-    }
+  if (!file) {
+    std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
+    return;
+  }
 
-    // for (auto t = 0; t < m.num_texture(); ++t) {
-    //   std::fprintf(file, "vt %lf %lf %lf\n", m.t[t * 3], m.t[t * 3 + 1],
-    //                m.t[t * 3 + 2]);
-    // }
+  {
+    const auto format = [&](char* p, size_t v) {
+      *p++ = 'v';
+      for (auto k = 0; k < 3; ++k) {
+        *p++ = ' ';
+        p = format_scalar(p, m.v[v * 3 + k], precision);
+      }
+      *p++ = '\n';
+      return p;
+    };
+    write_lines(file, m.num_vertices(),
+                4 + 3 * (MAX_DOUBLE_SIZE + std::max(precision, 0)), format,
+                num_threads);
+  }
 
-    // for (auto n = 0; n < m.num_normals(); ++n) {
-    //   std::fprintf(file, "vn %lf %lf %lf\n", m.n[n * 3], m.n[n * 3 + 1],
-    //                m.n[n * 3 + 2]);
-    // }
+  // Texture and normal coordinates are not written, only their indices.
+  const auto* f2t = m.num_texture() != 0 ? m.f2t.data() : nullptr;
+  const auto* f2n = m.num_normals() != 0 ? m.f2n.data() : nullptr;
 
-    if (m.num_texture() == 0 && m.num_normals() == 0) {
-      for (auto f = 0; f < m.num_faces(); ++f) {
-        std::fprintf(file, "f %d %d %d\n", m.f2v[f * 3] + 1,
-                     m.f2v[f * 3 + 1] + 1, m.f2v[f * 3 + 2] + 1);
-      }
-    } else if (m.num_texture() != 0 && m.num_normals() == 0) {
-      for (auto f = 0; f < m.num_faces(); ++f) {
-        std::fprintf(file, "f %d/%d %d/%d %d/%d\n", m.f2v[f * 3] + 1,
-                     m.f2t[f * 3] + 1, m.f2v[f * 3 + 1] + 1,
-                     m.f2t[f * 3 + 1] + 1, m.f2v[f * 3 + 2] + 1,
-                     m.f2t[f * 3 + 2] + 1);
-      }
-    } else if (m.num_texture() == 0 && m.num_normals() != 0) {
-      for (auto f = 0; f < m.num_faces(); ++f) {
-        std::fprintf(file, "f %d//%d %d//%d %d//%d\n", m.f2v[f * 3] + 1,
-                     m.f2n[f * 3] + 1, m.f2v[f * 3 + 1] + 1,
-                     m.f2n[f * 3 + 1] + 1, m.f2v[f * 3 + 2] + 1,
-                     m.f2n[f * 3 + 2] + 1);
-      }
-    } else {
-      for (auto f = 0; f < m.num_faces(); ++f) {
-        std::fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", m.f2v[f * 3] + 1,
-                     m.f2t[f * 3] + 1, m.f2n[f * 3] + 1, m.f2v[f * 3 + 1] + 1,
-                     m.f2t[f * 3 + 1] + 1, m.f2n[f * 3 + 1] + 1,
-                     m.f2v[f * 3 + 2] + 1, m.f2t[f * 3 + 2] + 1,
-                     m.f2n[f * 3 + 2] + 1);
+  const auto format = [&](char* p, size_t f) {
+    *p++ = 'f';
+    for (auto k = 0; k < 3; ++k) {
+      *p++ = ' ';
+      p = format_index(p, m.f2v[f * 3 + k]);
+      if (f2t || f2n) *p++ = '/';
+      if (f2t) p = format_index(p, f2t[f * 3 + k]);
+      if (f2n) {
+        *p++ = '/';
+        p = format_index(p, f2n[f * 3 + k]);
       }
     }
-  } else {
-    std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
-  }
+    *p++ = '\n';
+    return p;
+  };
+  write_lines(file, m.num_faces(), 4 + 3 * (3 * MAX_INDEX_SIZE<Index> + 3),
+              format, num_threads);
+
   std::fclose(file);
-}
\ No newline at end of file
+}
+
+template void writeOBJ(std::string_view, Mesh&, int, unsigned);
+template void writeOBJ(std::string_view, FloatMesh&, int, unsigned);
+template void writeOBJ(std::string_view, LargeMesh&, int, unsigned);
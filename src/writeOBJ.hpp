@@ -3,5 +3,13 @@
 #include <string_view>
 
 #include "Mesh.hpp"
+#include "parallel_task.hpp"
 
-void writeOBJ(std::string_view filepath, Mesh& m);
\ No newline at end of file
+// Coordinates are written with the shortest representation that round-trips
+// unless a precision (number of significant digits) is given. Blocks of lines
+// are formatted in parallel and flushed in order. Instantiated for Mesh,
+// FloatMesh and LargeMesh.
+template <typename Scalar, typename Index>
+void writeOBJ(std::string_view filepath, BasicMesh<Scalar, Index>& m,
+              int precision = -1,
+              unsigned num_threads = utl::NUM_HARDWARE_THREADS);
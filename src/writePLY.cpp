@@ -0,0 +1,57 @@
+#include "writePLY.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "Mesh.hpp"
+
+template <typename Scalar, typename Index>
+void writePLY(std::string_view filepath, const BasicMesh<Scalar, Index>& m) {
+  static_assert(sizeof(Index) == 4);
+  assert(m.num_vertices() > 0);
+  assert(m.num_faces() > 0);
+
+  if constexpr (std::endian::native != std::endian::little) {
+    std::fprintf(stderr,
+                 "ERROR: Writing PLY files requires a little-endian host.\n");
+    return;
+  }
+
+  std::FILE* file = std::fopen(filepath.data(), "wb");
+
+  if (!file) {
+    std::fprintf(stderr, "WARNING: Could not open \"%s\".\n", filepath.data());
+    return;
+  }
+
+  const char* type = sizeof(Scalar) == 4 ? "float" : "double";
+  std::fprintf(file,
+               "ply\nformat binary_little_endian 1.0\n"
+               "element vertex %zu\n"
+               "property %s x\nproperty %s y\nproperty %s z\n"
+               "element face %zu\n"
+               "property list uchar int vertex_indices\nend_header\n",
+               m.num_vertices(), type, type, type, m.num_faces());
+
+  // Positions have the same layout of the file.
+  std::fwrite(m.v.data(), sizeof(Scalar), m.v.size(), file);
+
+  // Every face record is the count followed by the 3 indices.
+  constexpr size_t FACE_SIZE = 1 + 3 * sizeof(Index);
+  std::vector<char> buf(m.num_faces() * FACE_SIZE);
+  for (size_t f = 0; f < m.num_faces(); ++f) {
+    buf[f * FACE_SIZE] = 3;
+    std::memcpy(&buf[f * FACE_SIZE + 1], &m.f2v[f * 3], 3 * sizeof(Index));
+  }
+  std::fwrite(buf.data(), 1, buf.size(), file);
+
+  std::fclose(file);
+}
+
+template void writePLY(std::string_view, const Mesh&);
+template void writePLY(std::string_view, const FloatMesh&);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string_view>
+
+#include "Mesh.hpp"
+
+// Write vertex positions and triangles as a binary little-endian PLY file.
+// Instantiated for Mesh and FloatMesh (PLY has no 64-bit integer type).
+template <typename Scalar, typename Index>
+void writePLY(std::string_view filepath, const BasicMesh<Scalar, Index>& m);
@@ -9,8 +9,9 @@
 
 #include "Mesh.hpp"
 
-static void writeVTK_edge_patch(std::string_view filepath, const Mesh& m,
-                                int e) {
+template <typename Scalar, typename Index>
+void writeVTK_edge_patch(std::string_view filepath,
+                         const BasicMesh<Scalar, Index>& m, Index e) {
   assert(!m.edel[e]);
 
   auto v0 = m.e2v[e * 2];
@@ -22,7 +23,7 @@ static void writeVTK_edge_patch(std::string_view filepath, const Mesh& m,
   assert(f0 != -1);
   auto f1 = m.e2f[e * 2 + 1];
 
-  std::vector<int> vs;
+  std::vector<Index> vs;
 
   for (auto vv : m.v2v[v0]) {
     if (m.vdel[vv]) continue;
@@ -37,7 +38,7 @@ static void writeVTK_edge_patch(std::string_view filepath, const Mesh& m,
   std::sort(vs.begin(), vs.end());
   vs.erase(std::unique(vs.begin(), vs.end()), vs.end());
 
-  std::vector<int> fs;
+  std::vector<Index> fs;
 
   for (auto ff : m.v2f[v0]) {
     if (m.vdel[ff]) continue;
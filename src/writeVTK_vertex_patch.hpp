@@ -9,11 +9,12 @@
 
 #include "Mesh.hpp"
 
-static void writeVTK_vertex_patch(std::string_view filepath, const Mesh& m,
-                                  int v) {
+template <typename Scalar, typename Index>
+void writeVTK_vertex_patch(std::string_view filepath,
+                           const BasicMesh<Scalar, Index>& m, Index v) {
   assert(!m.vdel[v]);
 
-  std::vector<int> vs;
+  std::vector<Index> vs;
 
   vs.push_back(v);
   for (auto vv : m.v2v[v]) {
@@ -24,7 +25,7 @@ static void writeVTK_vertex_patch(std::string_view filepath, const Mesh& m,
   std::sort(vs.begin(), vs.end());
   vs.erase(std::unique(vs.begin(), vs.end()), vs.end());
 
-  std::vector<int> fs;
+  std::vector<Index> fs;
 
   for (auto ff : m.v2f[v]) {
     if (m.vdel[ff]) continue;